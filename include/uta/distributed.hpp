@@ -116,7 +116,7 @@ public:
         size_t micro_batch_size;
     };
     
-    static std::shared_ptr<ModelParallel> create(
+    static std::shared_ptr<DistributedModelParallel> create(
         const ParallelConfig& config
     );
     
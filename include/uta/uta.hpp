@@ -14,6 +14,15 @@ class Device;
 class Stream;
 class Event;
 
+namespace core {
+class TensorStorage;
+}
+
+namespace runtime {
+class StreamQueue;
+class EventState;
+}
+
 // API version
 constexpr int UTA_VERSION_MAJOR = 1;
 constexpr int UTA_VERSION_MINOR = 0;
@@ -68,9 +77,18 @@ struct ContextConfig {
 struct DeviceConfig {
     DeviceType type;
     int device_id;
-    size_t memory_limit;
+    size_t memory_limit;        // resident tensor bytes, 0 = unlimited; see Device::configure
     bool enable_tensor_cores;
     bool enable_peer_access;
+    size_t host_spill_limit;    // host memory for spilled tensors, 0 = unlimited
+    std::string spill_dir;      // spill to files here past host_spill_limit, empty = never
+};
+
+// Tensor file mapping options
+struct MapOptions {
+    bool populate = false;          // MAP_POPULATE, fault the whole file in at map time
+    bool readahead = true;          // sequential + willneed hints to the page cache
+    size_t prefault_threads = 0;    // touch pages from this many threads after mapping
 };
 
 // Context class
@@ -112,6 +130,7 @@ public:
     std::shared_ptr<Event> createEvent();
     
     // Device control
+    void configure(const DeviceConfig& config);     // applies memory_limit and spill tiers to device tensors
     void synchronize();
     bool supportsPeerAccess(const Device& peer);
     void enablePeerAccess(const Device& peer);
@@ -126,13 +145,31 @@ public:
         DataType dtype,
         Device& device
     );
+
+    // Wrap read-only host storage without copying; storage keeps the memory alive
+    static std::shared_ptr<const Tensor> wrap(
+        const std::vector<size_t>& shape,
+        DataType dtype,
+        Device& device,
+        std::shared_ptr<const void> storage
+    );
+
+    // Zero-copy load of a tensor from an on-disk tensor file (io::TensorFileWriter);
+    // copyFrom the result into a tensor to get a writable copy
+    static std::shared_ptr<const Tensor> mapFile(
+        const std::string& path,
+        const std::string& name,
+        Device& device,
+        const MapOptions& options = MapOptions()
+    );
     
-    // data access
+    // data access; the const overload never copies. The mutable overload
+    // first un-shares shared or read-only storage, which copies it
     template<typename T>
-    T* data();
+    T* data() { return static_cast<T*>(mutableData()); }
     
     template<typename T>
-    const T* data() const;
+    const T* data() const { return static_cast<const T*>(constData()); }
     
     // Tensor information
     std::vector<size_t> getShape() const;
@@ -140,19 +177,63 @@ public:
     size_t getSize() const;
     DataType getDataType() const;
     Device& getDevice() const;
+    bool isReadOnly() const;
     
-    // data transmission
+    // data transmission; same-device copies share storage until either side
+    // writes. copyFrom rebinds the destination to the shared storage, so
+    // pointers taken from its mutable data() before the copy no longer alias
+    // it, while writes through the source's earlier pointers reach both
+    // tensors; take pointers again after copying
     void copyTo(Tensor& dst);
     void copyFrom(const Tensor& src);
     
-    // Memory management
+    // Memory management; fill takes one element of the tensor's data type.
+    // Both write through the mutable data(), un-sharing shared storage
     void zero();
     void fill(const void* value);
+
+private:
+    void* mutableData();
+    const void* constData() const;
+
+    std::shared_ptr<core::TensorStorage> storage_;
+    std::vector<size_t> shape_;
+    DataType dtype_{DataType::FLOAT32};
+    Device* device_{nullptr};
+};
+
+// Pins device tensors that live under a memory limit (Device::configure).
+// data() on such a tensor pins it in device memory until the innermost
+// TensorScope on the calling thread ends, and throws outside any scope;
+// after that the tensor may be spilled and the pointer is invalid. Each
+// scheduler task runs in a scope of its own. Pins are counted, so nested
+// scopes and tensors sharing storage each hold their own.
+class TensorScope {
+public:
+    TensorScope();
+    ~TensorScope();
+
+    TensorScope(const TensorScope&) = delete;
+    TensorScope& operator=(const TensorScope&) = delete;
+
+private:
+    struct Pin {
+        std::weak_ptr<const core::TensorStorage> storage;
+        void* data;
+    };
+
+    TensorScope* outer_;
+    std::vector<Pin> pins_;
+
+    friend class core::TensorStorage;
 };
 
 // Stream class
+// Work queued on a stream runs in order; separate streams run concurrently
 class Stream {
 public:
+    Stream();
+
     // Stream control
     void synchronize();
     bool query();
@@ -164,16 +245,34 @@ public:
     
     // Computation operations
     void launch(const std::function<void()>& kernel);
+
+    // Run callback on a host thread once all work queued so far has completed
+    void addCallback(std::function<void()> callback);
+
+private:
+    std::shared_ptr<runtime::StreamQueue> queue_;
+
+    friend class Event;
 };
 
 // Event class
 class Event {
 public:
+    Event();
+
     // Event control
     void record(Stream& stream);
     void synchronize();
     bool query();
-    float elapsed(const Event& start);
+    float elapsed(const Event& start);     // milliseconds since start
+
+    // Run callback on a host thread once the recorded work has completed
+    void addCallback(std::function<void()> callback);
+
+private:
+    std::shared_ptr<runtime::EventState> state_;
+
+    friend class Stream;
 };
 
 // Global functions
@@ -0,0 +1,256 @@
+#include "compile_queue.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace uta {
+namespace compiler {
+
+namespace {
+
+// In-process identity of a key; the source is part of it
+std::string identityOf(const KernelKey& key) {
+    std::string identity;
+    identity.reserve(key.source.size() + key.target_arch.size() + key.options.size() +
+                     key.compiler_version.size() + 3);
+    identity.append(key.source).push_back('\0');
+    identity.append(key.target_arch).push_back('\0');
+    identity.append(key.options).push_back('\0');
+    identity.append(key.compiler_version);
+    return identity;
+}
+
+std::string describe(const KernelKey& key) {
+    return "kernel for " + key.target_arch + " (" + key.options + ")";
+}
+
+} // namespace
+
+// KernelHandle
+
+KernelHandle::KernelHandle(KernelKey key, void* fallback)
+    : key_(std::move(key))
+    , entry_(fallback)
+    , ready_(promise_.get_future().share())
+{}
+
+void KernelHandle::complete(void* entry, std::shared_ptr<const void> code) {
+    code_ = std::move(code);
+    // Publishes the code before any launch can pick the pointer up
+    entry_.store(entry, std::memory_order_release);
+    specialized_.store(true, std::memory_order_release);
+    promise_.set_value();
+}
+
+void KernelHandle::fail(std::exception_ptr error) {
+    promise_.set_exception(error);
+}
+
+// CompileQueue
+
+CompileQueue& CompileQueue::getInstance() {
+    static CompileQueue instance;
+    return instance;
+}
+
+CompileQueue::~CompileQueue() {
+    shutdown();
+}
+
+void CompileQueue::setConfig(const QueueConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!threads_.empty()) {
+        throw std::runtime_error("Compile queue config cannot change while compiling");
+    }
+    config_ = config;
+}
+
+std::shared_ptr<KernelHandle> CompileQueue::submit(const KernelKey& key, void* fallback,
+                                                   CompileFunction compile, LoadFunction load) {
+    if (!compile || !load) {
+        throw std::invalid_argument("Compile and load functions must not be empty");
+    }
+    requests_.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_ptr<KernelHandle> handle;
+    std::shared_ptr<KernelCache> cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            throw std::runtime_error("Compile queue is shutting down");
+        }
+        std::string identity = identityOf(key);
+        auto it = handles_.find(identity);
+        if (it != handles_.end()) {
+            deduplicated_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+        handle = std::make_shared<KernelHandle>(key, fallback);
+        handles_.emplace(std::move(identity), handle);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        cache = config_.cache;
+    }
+
+    // A cached kernel is loaded right here and never compiled; the lookup
+    // maps a file, so it stays outside the lock
+    if (cache) {
+        std::shared_ptr<const CachedKernel> cached;
+        void* entry = nullptr;
+        try {
+            cached = cache->load(key);
+            if (cached) {
+                entry = load(cached->code, cached->size);
+            }
+        } catch (...) {
+            // An unreadable or unloadable entry is a miss; the compile replaces it
+            entry = nullptr;
+        }
+        if (entry != nullptr) {
+            cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            finish(handle, entry, std::move(cached), nullptr);
+            return handle;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        lock.unlock();
+        std::exception_ptr error =
+            std::make_exception_ptr(std::runtime_error("Compile queue is shutting down"));
+        finish(handle, nullptr, nullptr, error);
+        std::rethrow_exception(error);
+    }
+    queue_.push_back(Request{handle, std::move(compile), std::move(load), std::move(cache)});
+    if (threads_.empty()) {
+        start();
+    }
+    lock.unlock();
+    condition_.notify_one();
+    return handle;
+}
+
+std::shared_ptr<KernelHandle> CompileQueue::find(const KernelKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = handles_.find(identityOf(key));
+    return it != handles_.end() ? it->second : nullptr;
+}
+
+void CompileQueue::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = handles_.begin(); it != handles_.end();) {
+        // Pending keys stay so their requests are still deduplicated
+        if (it->second->isSpecialized()) {
+            it = handles_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CompileQueue::shutdown() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        threads.swap(threads_);
+    }
+    condition_.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+}
+
+CompileQueue::QueueStats CompileQueue::getStats() const {
+    return QueueStats{
+        requests_.load(std::memory_order_relaxed),
+        deduplicated_.load(std::memory_order_relaxed),
+        cache_hits_.load(std::memory_order_relaxed),
+        compiled_.load(std::memory_order_relaxed),
+        failed_.load(std::memory_order_relaxed),
+        pending_.load(std::memory_order_relaxed)
+    };
+}
+
+// Caller holds mutex_
+void CompileQueue::start() {
+    size_t num_threads = config_.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency() / 4);
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads_.emplace_back(&CompileQueue::compileLoop, this);
+    }
+}
+
+void CompileQueue::compileLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // Queued compiles finish even when stopping, so no handle waits forever
+        condition_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        Request request = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        const KernelKey& key = request.handle->getKey();
+        void* entry = nullptr;
+        std::shared_ptr<std::vector<uint8_t>> compiled;
+        std::exception_ptr error;
+        try {
+            compiled = std::make_shared<std::vector<uint8_t>>(request.compile());
+            if (compiled->empty()) {
+                throw std::runtime_error("Compiling " + describe(key) + " produced no code");
+            }
+            entry = request.load(compiled->data(), compiled->size());
+            if (entry == nullptr) {
+                throw std::runtime_error("Loading " + describe(key) + " produced no entry point");
+            }
+            compiled_.fetch_add(1, std::memory_order_relaxed);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (!error && request.cache) {
+            try {
+                request.cache->store(key, compiled->data(), compiled->size());
+            } catch (...) {
+                // The kernel works; only the next process pays for the lost entry
+            }
+        }
+
+        std::shared_ptr<const void> code;
+        if (!error) {
+            code = std::shared_ptr<const void>(compiled, compiled->data());
+        }
+        finish(request.handle, entry, std::move(code), error);
+        lock.lock();
+    }
+}
+
+void CompileQueue::finish(const std::shared_ptr<KernelHandle>& handle, void* entry,
+                          std::shared_ptr<const void> code, std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error) {
+            // Let the next request for this key retry
+            auto it = handles_.find(identityOf(handle->getKey()));
+            if (it != handles_.end() && it->second == handle) {
+                handles_.erase(it);
+            }
+            failed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Waiters may run arbitrary code; never under the lock
+    if (error) {
+        handle->fail(error);
+    } else {
+        handle->complete(entry, std::move(code));
+    }
+}
+
+} // namespace compiler
+} // namespace uta
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "kernel_cache.hpp"
+
+namespace uta {
+namespace compiler {
+
+// Entry point of a kernel that may still be compiling
+//
+// Starts out as the generic fallback kernel and switches to the specialized
+// one the moment its compilation finishes. Callers load the entry point on
+// every launch, so a launch uses one kernel or the other, never a mix.
+class KernelHandle {
+public:
+    KernelHandle(KernelKey key, void* fallback);
+
+    // Specialized kernel once compiled, else the fallback
+    void* get() const { return entry_.load(std::memory_order_acquire); }
+
+    template<typename Fn>
+    Fn* as() const { return reinterpret_cast<Fn*>(get()); }
+
+    bool isSpecialized() const { return specialized_.load(std::memory_order_acquire); }
+
+    // Blocks until compilation has finished; rethrows a compile failure,
+    // after which the fallback stays in use
+    void wait() const { ready_.get(); }
+    std::shared_future<void> getFuture() const { return ready_; }
+
+    const KernelKey& getKey() const { return key_; }
+
+private:
+    friend class CompileQueue;
+
+    // code stays alive as long as the handle, for loaders that run it in place
+    void complete(void* entry, std::shared_ptr<const void> code);
+    void fail(std::exception_ptr error);
+
+    KernelKey key_;
+    std::shared_ptr<const void> code_;
+    std::atomic<void*> entry_;
+    std::atomic<bool> specialized_{false};
+    std::promise<void> promise_;
+    std::shared_future<void> ready_;
+};
+
+// Background kernel compilation
+//
+// Compiles run on a few dedicated threads, not the runtime scheduler's
+// workers: a compile takes hundreds of milliseconds and would hold a
+// compute worker for that long. Requests are keyed; a request for a key
+// that is queued, compiling or compiled returns the existing handle, so
+// each kernel compiles once per process. A failed compile drops its key and
+// the next request retries.
+//
+// With a KernelCache configured, a request first looks its key up there and
+// loads a hit right away without compiling; compiled code is stored for the
+// next process.
+//
+// JITCompiler has no compile path in this tree, so it does not submit here
+// itself. Callers pass the compile step, a loader that turns code into an
+// entry point, and a generic precompiled kernel.
+class CompileQueue {
+public:
+    using CompileFunction = std::function<std::vector<uint8_t>()>;
+    using LoadFunction = std::function<void*(const void* code, size_t size)>;
+
+    struct QueueConfig {
+        size_t num_threads;         // 0 = a quarter of the hardware threads, at least one
+        std::shared_ptr<KernelCache> cache;     // e.g. KernelCache::open(), nullptr = compile
+                                                // in every process
+    };
+
+    struct QueueStats {
+        size_t requests;
+        size_t deduplicated;        // requests answered by an existing handle
+        size_t cache_hits;          // requests loaded from the kernel cache
+        size_t compiled;
+        size_t failed;
+        size_t pending;             // queued or compiling
+    };
+
+    static CompileQueue& getInstance();
+
+    ~CompileQueue();
+
+    // Only while no compile threads are running, i.e. before the first
+    // submit or after shutdown
+    void setConfig(const QueueConfig& config);
+
+    // fallback serves until the compiled code is loaded; for a deduplicated
+    // request the first request's fallback and functions are kept
+    std::shared_ptr<KernelHandle> submit(const KernelKey& key, void* fallback,
+                                         CompileFunction compile, LoadFunction load);
+
+    // nullptr if the key was never submitted or its compile failed
+    std::shared_ptr<KernelHandle> find(const KernelKey& key) const;
+
+    // Forget compiled kernels; handles already returned stay valid
+    void clear();
+
+    // Finish queued compiles and stop the threads; submit restarts them
+    void shutdown();
+
+    QueueStats getStats() const;
+
+private:
+    struct Request {
+        std::shared_ptr<KernelHandle> handle;
+        CompileFunction compile;
+        LoadFunction load;
+        std::shared_ptr<KernelCache> cache;
+    };
+
+    CompileQueue() = default;
+
+    CompileQueue(const CompileQueue&) = delete;
+    CompileQueue& operator=(const CompileQueue&) = delete;
+
+    void start();
+    void compileLoop();
+    void finish(const std::shared_ptr<KernelHandle>& handle, void* entry,
+                std::shared_ptr<const void> code, std::exception_ptr error);
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Request> queue_;
+    std::unordered_map<std::string, std::shared_ptr<KernelHandle>> handles_;
+    std::vector<std::thread> threads_;
+    QueueConfig config_{0, nullptr};
+    bool stopping_{false};
+
+    std::atomic<size_t> requests_{0};
+    std::atomic<size_t> deduplicated_{0};
+    std::atomic<size_t> cache_hits_{0};
+    std::atomic<size_t> compiled_{0};
+    std::atomic<size_t> failed_{0};
+    std::atomic<size_t> pending_{0};
+};
+
+} // namespace compiler
+} // namespace uta
@@ -0,0 +1,263 @@
+#include "kernel_cache.hpp"
+#include "core/io/checksum.hpp"
+#include "core/io/tensor_file.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uta {
+namespace compiler {
+
+namespace {
+
+constexpr size_t kCodeAlignment = 64;
+constexpr char kEntrySuffix[] = ".kernel";
+
+std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+void writeFully(int fd, const void* data, size_t size, uint64_t offset, const std::string& path) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw ioError("Failed to write kernel cache entry", path);
+        }
+        bytes += written;
+        offset += static_cast<uint64_t>(written);
+        size -= static_cast<size_t>(written);
+    }
+}
+
+// mkdir -p
+void createDirectories(const std::string& path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = path.substr(0, slash);
+        if (!prefix.empty() && ::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw ioError("Failed to create kernel cache directory", prefix);
+        }
+        if (slash == std::string::npos) {
+            return;
+        }
+    }
+}
+
+// The stored part of a key, compared byte for byte on load
+std::string keyStrings(const KernelKey& key) {
+    std::string strings;
+    strings.reserve(key.target_arch.size() + key.options.size() + key.compiler_version.size() + 2);
+    strings.append(key.target_arch).push_back('\0');
+    strings.append(key.options).push_back('\0');
+    strings.append(key.compiler_version);
+    return strings;
+}
+
+std::string withoutTrailingSlashes(std::string path) {
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+    return path;
+}
+
+bool endsWith(const std::string& name, const std::string& suffix) {
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+KernelCache::KernelCache(std::string directory)
+    : directory_(std::move(directory))
+{
+    if (directory_.empty()) {
+        throw std::invalid_argument("Kernel cache directory must not be empty");
+    }
+    directory_ = withoutTrailingSlashes(std::move(directory_));
+    createDirectories(directory_);
+}
+
+std::shared_ptr<KernelCache> KernelCache::open(const ContextConfig& config) {
+    if (config.cache_dir.empty()) {
+        return nullptr;
+    }
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<KernelCache>> caches;
+
+    std::string directory = withoutTrailingSlashes(config.cache_dir);
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<KernelCache>& slot = caches[directory];
+    std::shared_ptr<KernelCache> cache = slot.lock();
+    if (!cache) {
+        cache = std::make_shared<KernelCache>(directory);
+        slot = cache;
+    }
+    return cache;
+}
+
+uint64_t KernelCache::hashKey(const KernelKey& key) {
+    // FNV-1a over each field and its length, so fields cannot run together
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+    };
+    for (const std::string* field : {&key.source, &key.target_arch, &key.options,
+                                     &key.compiler_version}) {
+        uint64_t length = field->size();
+        mix(&length, sizeof(length));
+        mix(field->data(), field->size());
+    }
+    return hash;
+}
+
+std::shared_ptr<const CachedKernel> KernelCache::load(const KernelKey& key) {
+    uint64_t hash = hashKey(key);
+    std::string path = pathOf(hash);
+    if (::access(path.c_str(), R_OK) != 0) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    std::shared_ptr<io::MappedFile> file;
+    try {
+        MapOptions options;
+        options.readahead = false;
+        file = io::MappedFile::open(path, options);
+    } catch (const std::runtime_error&) {
+        // Removed by another process since the access check
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const uint8_t* data = file->data();
+    size_t size = file->size();
+    std::string strings = keyStrings(key);
+    KernelBlobHeader header;
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, kKernelBlobMagic, sizeof(header.magic)) == 0 &&
+                header.version == kKernelBlobVersion &&
+                header.key_hash == hash &&
+                header.source_size == key.source.size() &&
+                header.key_size == strings.size() &&
+                sizeof(header) + strings.size() <= size &&
+                header.code_offset >= sizeof(header) + strings.size() &&
+                header.code_offset <= size &&
+                header.code_size <= size - header.code_offset;
+    }
+    valid = valid &&
+            std::memcmp(data + sizeof(header), strings.data(), strings.size()) == 0 &&
+            header.source_checksum == io::crc32c(key.source.data(), key.source.size()) &&
+            header.code_checksum == io::crc32c(data + header.code_offset, header.code_size);
+    if (!valid) {
+        // A hash collision, a stale format or a torn write; the next store replaces it
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    auto kernel = std::make_shared<CachedKernel>();
+    kernel->code = data + header.code_offset;
+    kernel->size = header.code_size;
+    kernel->file = std::move(file);
+    return kernel;
+}
+
+void KernelCache::store(const KernelKey& key, const void* code, size_t size) {
+    uint64_t hash = hashKey(key);
+    std::string strings = keyStrings(key);
+
+    KernelBlobHeader header{};
+    std::memcpy(header.magic, kKernelBlobMagic, sizeof(header.magic));
+    header.version = kKernelBlobVersion;
+    header.code_checksum = io::crc32c(code, size);
+    header.key_hash = hash;
+    header.source_size = key.source.size();
+    header.source_checksum = io::crc32c(key.source.data(), key.source.size());
+    header.key_size = static_cast<uint32_t>(strings.size());
+    header.code_offset = io::alignUp(sizeof(header) + strings.size(), kCodeAlignment);
+    header.code_size = size;
+
+    // Unique per process and call, so concurrent writers never share a file
+    static std::atomic<uint64_t> sequence{0};
+    std::string path = pathOf(hash);
+    std::string temp_path = path + ".tmp." + std::to_string(::getpid()) + "." +
+                            std::to_string(sequence.fetch_add(1, std::memory_order_relaxed));
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Failed to create kernel cache entry", temp_path);
+    }
+    try {
+        if (::ftruncate(fd, static_cast<off_t>(header.code_offset + size)) != 0) {
+            throw ioError("Failed to size kernel cache entry", temp_path);
+        }
+        writeFully(fd, strings.data(), strings.size(), sizeof(header), temp_path);
+        writeFully(fd, code, size, header.code_offset, temp_path);
+        writeFully(fd, &header, sizeof(header), 0, temp_path);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temp_path.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    // Last writer wins; every candidate is complete and equivalent
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        ::unlink(temp_path.c_str());
+        throw ioError("Failed to publish kernel cache entry", path);
+    }
+    stores_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void KernelCache::remove(const KernelKey& key) {
+    ::unlink(pathOf(hashKey(key)).c_str());
+}
+
+void KernelCache::clear() {
+    DIR* dir = ::opendir(directory_.c_str());
+    if (dir == nullptr) {
+        throw ioError("Failed to open kernel cache directory", directory_);
+    }
+    while (const dirent* entry = ::readdir(dir)) {
+        // Temporary files may belong to a live writer and are left alone
+        std::string name = entry->d_name;
+        if (endsWith(name, kEntrySuffix)) {
+            ::unlink((directory_ + "/" + name).c_str());
+        }
+    }
+    ::closedir(dir);
+}
+
+KernelCache::CacheStats KernelCache::getStats() const {
+    return CacheStats{
+        hits_.load(std::memory_order_relaxed),
+        misses_.load(std::memory_order_relaxed),
+        stores_.load(std::memory_order_relaxed),
+        rejected_.load(std::memory_order_relaxed)
+    };
+}
+
+std::string KernelCache::pathOf(uint64_t hash) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return directory_ + "/" + name + kEntrySuffix;
+}
+
+} // namespace compiler
+} // namespace uta
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace uta {
+struct ContextConfig;
+
+namespace io {
+class MappedFile;
+}
+
+namespace compiler {
+
+// Persistent cache of compiled kernels
+//
+// One file per kernel, named by a 64-bit hash of its key:
+//
+//   [KernelBlobHeader][target arch \0 options \0 compiler version][pad][code]
+//
+// Files are written to a private temporary name and renamed into place, so
+// concurrent processes compiling the same kernel each publish a complete
+// file and readers never see a partial one. The full key is stored in the
+// file and compared on load, and the code carries a CRC32C; a file that
+// does not match is treated as a miss and removed. Loaded code is mapped,
+// not read.
+//
+// JITCompiler does not consult the cache: it has no compile path in this
+// tree to hook into. KernelCache::open() gives the process's cache on
+// ContextConfig::cache_dir; hand it to CompileQueue, which loads before
+// compiling and stores the result.
+constexpr char kKernelBlobMagic[8] = {'U', 'T', 'A', 'K', 'E', 'R', 'N', '\0'};
+constexpr uint32_t kKernelBlobVersion = 1;
+
+struct KernelBlobHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t code_checksum;     // CRC32C of the code
+    uint64_t key_hash;
+    uint64_t source_size;
+    uint32_t source_checksum;   // CRC32C of the source
+    uint32_t key_size;          // bytes of the key strings after the header
+    uint64_t code_offset;       // absolute, 64-byte aligned
+    uint64_t code_size;
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(KernelBlobHeader) == 64, "KernelBlobHeader layout changed");
+
+// Everything that decides the compiled code; any change is a different entry
+struct KernelKey {
+    std::string source;             // hashed, never stored
+    std::string target_arch;
+    std::string options;            // canonical form of the compile options
+    std::string compiler_version;
+};
+
+// Code of a cache hit; keeps the file mapped while held
+struct CachedKernel {
+    std::shared_ptr<io::MappedFile> file;
+    const uint8_t* code;
+    size_t size;
+};
+
+class KernelCache {
+public:
+    // Creates the directory if needed
+    explicit KernelCache(std::string directory);
+
+    // The process's cache on config.cache_dir, created by the first call;
+    // callers naming the same directory share it. nullptr when cache_dir is
+    // empty, i.e. kernels are not kept across processes
+    static std::shared_ptr<KernelCache> open(const ContextConfig& config);
+
+    // nullptr on a miss
+    std::shared_ptr<const CachedKernel> load(const KernelKey& key);
+
+    void store(const KernelKey& key, const void* code, size_t size);
+
+    void remove(const KernelKey& key);
+
+    // Remove every entry, including ones other processes wrote
+    void clear();
+
+    const std::string& directory() const { return directory_; }
+
+    struct CacheStats {
+        size_t hits;
+        size_t misses;
+        size_t stores;
+        size_t rejected;    // files dropped for a key mismatch or bad checksum
+    };
+
+    CacheStats getStats() const;
+
+    static uint64_t hashKey(const KernelKey& key);
+
+private:
+    std::string pathOf(uint64_t hash) const;
+
+    std::string directory_;
+
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> stores_{0};
+    std::atomic<size_t> rejected_{0};
+};
+
+} // namespace compiler
+} // namespace uta
@@ -0,0 +1,207 @@
+#include "checkpoint.hpp"
+#include "checksum.hpp"
+#include "core/memory_manager.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace uta {
+namespace io {
+
+namespace {
+
+std::string shardName(const std::string& name, size_t shard) {
+    return name + "/shard" + std::to_string(shard);
+}
+
+} // namespace
+
+// CheckpointWriter
+
+void CheckpointWriter::addTensor(const std::string& name, const Tensor& tensor) {
+    writer_.addTensor(name, tensor);
+}
+
+void CheckpointWriter::addTensor(const std::string& name,
+                                 distributed::DistributedTensor& tensor) {
+    auto shards = tensor.getAllTensors();
+    for (size_t i = 0; i < shards.size(); ++i) {
+        writer_.addTensor(shardName(name, i), *shards[i]);
+        shards_.push_back(shards[i]);
+    }
+}
+
+void CheckpointWriter::addBuffer(const std::string& name,
+                                 const std::vector<size_t>& shape,
+                                 DataType dtype,
+                                 const void* data) {
+    writer_.addTensor(name, shape, dtype, data);
+}
+
+void CheckpointWriter::save(const std::string& path, const WriteOptions& options) const {
+    if (!options.checksums) {
+        throw std::invalid_argument("Checkpoints are always written with checksums");
+    }
+    writer_.write(path, options);
+}
+
+// CheckpointReader
+
+CheckpointReader::CheckpointReader(const std::string& path) {
+    // The mapping only serves the index; payloads are read with pread
+    MapOptions map_options;
+    map_options.readahead = false;
+    file_ = TensorFile::open(path, map_options);
+
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open checkpoint '" + path + "': " +
+                                 std::strerror(errno));
+    }
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+CheckpointReader::~CheckpointReader() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool CheckpointReader::contains(const std::string& name) const {
+    return file_->contains(name);
+}
+
+const TensorView& CheckpointReader::info(const std::string& name) const {
+    return file_->find(name);
+}
+
+void CheckpointReader::addTensor(const std::string& name, Tensor& tensor) {
+    const TensorView& view = file_->find(name);
+    if (view.shape != tensor.getShape() || view.dtype != tensor.getDataType()) {
+        throw std::invalid_argument("Checkpoint tensor '" + name +
+                                    "' does not match the restore target");
+    }
+    targets_.push_back({&view, nullptr, &tensor, nullptr});
+}
+
+void CheckpointReader::addTensor(const std::string& name,
+                                 distributed::DistributedTensor& tensor) {
+    auto shards = tensor.getAllTensors();
+    for (size_t i = 0; i < shards.size(); ++i) {
+        addTensor(shardName(name, i), *shards[i]);
+    }
+}
+
+void CheckpointReader::addBuffer(const std::string& name, void* data, size_t size) {
+    const TensorView& view = file_->find(name);
+    if (view.size != size) {
+        throw std::invalid_argument("Checkpoint tensor '" + name + "' has " +
+                                    std::to_string(view.size) + " bytes, buffer has " +
+                                    std::to_string(size));
+    }
+    targets_.push_back({&view, data, nullptr, nullptr});
+}
+
+void CheckpointReader::readChunk(const TensorView& view, size_t chunk,
+                                 void* dst, bool verify) const {
+    size_t chunk_size = view.chunk_size == 0 ? view.size : view.chunk_size;
+    size_t begin = chunk * chunk_size;
+    size_t length = std::min(chunk_size, view.size - begin);
+
+    uint8_t* bytes = static_cast<uint8_t*>(dst);
+    size_t done = 0;
+    while (done < length) {
+        ssize_t got = ::pread(fd_, bytes + done, length - done,
+                              static_cast<off_t>(view.offset + begin + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            throw std::runtime_error("Failed to read checkpoint tensor '" + view.name + "'");
+        }
+        done += static_cast<size_t>(got);
+    }
+
+    if (verify && view.checksums != nullptr && crc32c(bytes, length) != view.checksums[chunk]) {
+        throw std::runtime_error("Checksum mismatch in checkpoint tensor '" + view.name +
+                                 "' chunk " + std::to_string(chunk));
+    }
+}
+
+void CheckpointReader::restore(const ReadOptions& options) {
+    struct Chunk {
+        const Target* target;
+        size_t index;
+    };
+    std::vector<Chunk> chunks;
+    // Device targets stay pinned until every chunk has landed
+    TensorScope scope;
+    for (auto& target : targets_) {
+        if (target.tensor != nullptr) {
+            // Un-shares copy-on-write storage before any chunk lands in it
+            target.data = target.tensor->data<uint8_t>();
+            if (target.tensor->getDevice().getType() != DeviceType::CPU) {
+                target.device = &target.tensor->getDevice();
+            }
+        }
+        size_t num_chunks = std::max<size_t>(1, target.view->numChunks());
+        for (size_t c = 0; c < num_chunks && target.view->size > 0; ++c) {
+            chunks.push_back({&target, c});
+        }
+    }
+
+    parallelFor(chunks.size(), options.num_threads, [&](size_t i) {
+        const Chunk& chunk = chunks[i];
+        const TensorView& view = *chunk.target->view;
+        size_t chunk_size = view.chunk_size == 0 ? view.size : view.chunk_size;
+        size_t offset = chunk.index * chunk_size;
+        uint8_t* dst = static_cast<uint8_t*>(chunk.target->data) + offset;
+        if (chunk.target->device == nullptr) {
+            readChunk(view, chunk.index, dst, options.verify_checksums);
+            return;
+        }
+
+        // pread cannot write device addresses; stage one chunk at a time
+        std::vector<uint8_t> staging(std::min(chunk_size, view.size - offset));
+        readChunk(view, chunk.index, staging.data(), options.verify_checksums);
+        core::MemoryManager::getInstance().copyHostToDevice(
+            dst, staging.data(), staging.size(), *chunk.target->device);
+    });
+    targets_.clear();
+}
+
+bool CheckpointReader::verify(size_t num_threads) const {
+    struct Chunk {
+        const TensorView* view;
+        size_t index;
+    };
+    std::vector<Chunk> chunks;
+    for (const auto& view : file_->tensors()) {
+        if (view.checksums == nullptr) {
+            return false;
+        }
+        for (size_t c = 0; c < view.numChunks(); ++c) {
+            chunks.push_back({&view, c});
+        }
+    }
+
+    // Checked straight from the mapping, one pass over the page cache
+    std::atomic<bool> ok{true};
+    parallelFor(chunks.size(), num_threads, [&](size_t i) {
+        const TensorView& view = *chunks[i].view;
+        size_t begin = chunks[i].index * view.chunk_size;
+        size_t length = std::min(view.chunk_size, view.size - begin);
+        const uint8_t* data = static_cast<const uint8_t*>(view.data) + begin;
+        if (crc32c(data, length) != view.checksums[chunks[i].index]) {
+            ok.store(false, std::memory_order_relaxed);
+        }
+    });
+    return ok.load();
+}
+
+} // namespace io
+} // namespace uta
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <uta/uta.hpp>
+#include <uta/distributed.hpp>
+#include "tensor_file.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uta {
+namespace io {
+
+// Checkpoints are tensor files written with per-chunk CRC32C, so a checkpoint
+// can also be opened with Tensor::mapFile. Distributed tensors are stored one
+// entry per shard, named "<name>/shard<i>".
+
+// Checkpoint writer
+class CheckpointWriter {
+public:
+    void addTensor(const std::string& name, const Tensor& tensor);
+    void addTensor(const std::string& name, distributed::DistributedTensor& tensor);
+    void addBuffer(const std::string& name,
+                   const std::vector<size_t>& shape,
+                   DataType dtype,
+                   const void* data);
+
+    // Tensors must not be written to until save() returns
+    void save(const std::string& path, const WriteOptions& options = WriteOptions()) const;
+
+private:
+    TensorFileWriter writer_;
+    std::vector<std::shared_ptr<Tensor>> shards_;   // keeps shard handles alive
+};
+
+// Checkpoint reader, restores into preallocated tensors
+class CheckpointReader {
+public:
+    struct ReadOptions {
+        size_t num_threads;         // 0 = hardware concurrency
+        bool verify_checksums;
+    };
+
+    explicit CheckpointReader(const std::string& path);
+    ~CheckpointReader();
+
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+    bool contains(const std::string& name) const;
+    const TensorView& info(const std::string& name) const;
+
+    // Queue a restore target; shape and data type must match the checkpoint.
+    // Tensor targets are written through whatever storage they hold at restore()
+    void addTensor(const std::string& name, Tensor& tensor);
+    void addTensor(const std::string& name, distributed::DistributedTensor& tensor);
+    void addBuffer(const std::string& name, void* data, size_t size);
+
+    // Reads all queued targets chunk-parallel; throws on checksum mismatch
+    void restore(const ReadOptions& options = {0, true});
+
+    // Checks every chunk of every tensor without restoring anything
+    bool verify(size_t num_threads = 0) const;
+
+private:
+    struct Target {
+        const TensorView* view;
+        void* data;
+        Tensor* tensor;     // resolved to data in restore(), after any storage rebinding
+        Device* device;     // set for device tensors, which are staged through host memory
+    };
+
+    void readChunk(const TensorView& view, size_t chunk, void* dst, bool verify) const;
+
+    std::shared_ptr<TensorFile> file_;
+    int fd_{-1};
+    std::vector<Target> targets_;
+};
+
+} // namespace io
+} // namespace uta
@@ -0,0 +1,127 @@
+#include "checksum.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <nmmintrin.h>
+#define UTA_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define UTA_CRC32C_ARM 1
+#endif
+
+namespace uta {
+namespace io {
+
+namespace {
+
+constexpr uint32_t kCrc32cPolynomial = 0x82F63B78;  // reflected
+
+// Slicing-by-8 tables for the portable path
+struct Crc32cTables {
+    std::array<std::array<uint32_t, 256>, 8> table;
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kCrc32cPolynomial & (0u - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t slice = 1; slice < 8; ++slice) {
+                uint32_t prev = table[slice - 1][i];
+                table[slice][i] = (prev >> 8) ^ table[0][prev & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32cTables& tables() {
+    static const Crc32cTables instance;
+    return instance;
+}
+
+uint32_t crc32cSoftware(const uint8_t* data, size_t size, uint32_t crc) {
+    const auto& t = tables().table;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        word ^= crc;
+        crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^
+              t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+              t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+              t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(UTA_CRC32C_X86)
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(const uint8_t* data, size_t size, uint32_t crc) {
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+#elif defined(UTA_CRC32C_ARM)
+uint32_t crc32cHardware(const uint8_t* data, size_t size, uint32_t crc) {
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = __crc32cb(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
+bool detectHardwareCrc32c() {
+#if defined(UTA_CRC32C_X86)
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(UTA_CRC32C_ARM)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+bool hasHardwareCrc32c() {
+    static const bool supported = detectHardwareCrc32c();
+    return supported;
+}
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#if defined(UTA_CRC32C_X86) || defined(UTA_CRC32C_ARM)
+    if (hasHardwareCrc32c()) {
+        return ~crc32cHardware(bytes, size, crc);
+    }
+#endif
+    return ~crc32cSoftware(bytes, size, crc);
+}
+
+} // namespace io
+} // namespace uta
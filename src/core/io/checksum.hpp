@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace uta {
+namespace io {
+
+// CRC32C (Castagnoli). Pass a previous result as crc to extend it over more data.
+// Uses the SSE4.2 / ARMv8 CRC instructions when the CPU has them.
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+// Whether crc32c runs on the hardware path
+bool hasHardwareCrc32c();
+
+} // namespace io
+} // namespace uta
@@ -0,0 +1,545 @@
+#include "tensor_file.hpp"
+#include "checksum.hpp"
+#include "core/memory_manager.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+namespace uta {
+namespace io {
+
+namespace {
+
+std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+// Makes a rename into the directory durable
+void syncParentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." :
+                            slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw ioError("Failed to open directory", directory);
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw ioError("Failed to sync directory", directory);
+    }
+}
+
+void writeFully(int fd, const void* data, size_t size, uint64_t offset, const std::string& path) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw ioError("Failed to write tensor file", path);
+        }
+        bytes += written;
+        offset += static_cast<uint64_t>(written);
+        size -= static_cast<size_t>(written);
+    }
+}
+
+// offset + length <= limit, without overflowing
+bool fitsWithin(uint64_t offset, uint64_t length, uint64_t limit) {
+    return offset <= limit && length <= limit - offset;
+}
+
+// Bytes of a tensor with the entry's shape and type; false on overflow
+bool expectedPayloadSize(const IndexEntry& entry, uint64_t& bytes) {
+    bytes = dataTypeSize(static_cast<DataType>(entry.dtype));
+    for (uint32_t d = 0; d < entry.ndim; ++d) {
+        uint64_t dim = entry.shape[d];
+        if (dim != 0 && bytes > UINT64_MAX / dim) {
+            return false;
+        }
+        bytes *= dim;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t dataTypeSize(DataType dtype) {
+    switch (dtype) {
+        case DataType::FLOAT32: return 4;
+        case DataType::FLOAT16: return 2;
+        case DataType::INT32:   return 4;
+        case DataType::INT64:   return 8;
+        case DataType::UINT32:  return 4;
+        case DataType::UINT64:  return 8;
+        case DataType::BOOL:    return 1;
+    }
+    throw std::invalid_argument("Unknown data type");
+}
+
+void parallelFor(size_t count, size_t num_threads, const std::function<void(size_t)>& fn) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, count);
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) {
+                return;
+            }
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// MappedFile
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, const MapOptions& options) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw ioError("Failed to open tensor file", path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw ioError("Failed to stat tensor file", path);
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (options.populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = size > 0 ? ::mmap(nullptr, size, PROT_READ, flags, fd, 0) : nullptr;
+    // The mapping holds its own reference to the file
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw ioError("Failed to map tensor file", path);
+    }
+
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->path_ = path;
+    file->addr_ = addr;
+    file->size_ = size;
+    file->device_ = st.st_dev;
+    file->inode_ = st.st_ino;
+    file->mtime_ = st.st_mtim;
+
+    if (size > 0 && options.readahead) {
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+        ::madvise(addr, size, MADV_WILLNEED);
+    }
+    if (size > 0 && options.prefault_threads > 0 && !options.populate) {
+        file->prefault(0, size, options.prefault_threads);
+    }
+    return file;
+}
+
+bool MappedFile::isCurrent() const {
+    struct stat st;
+    return ::stat(path_.c_str(), &st) == 0 &&
+           st.st_dev == device_ && st.st_ino == inode_ &&
+           static_cast<size_t>(st.st_size) == size_ &&
+           st.st_mtim.tv_sec == mtime_.tv_sec && st.st_mtim.tv_nsec == mtime_.tv_nsec;
+}
+
+void MappedFile::advise(const MapOptions& options) const {
+    if (size_ == 0) {
+        return;
+    }
+    if (options.readahead) {
+        ::madvise(addr_, size_, MADV_WILLNEED);
+    }
+    // MAP_POPULATE only applies at map time; touch the pages instead
+    if (options.populate || options.prefault_threads > 0) {
+        prefault(0, size_, std::max<size_t>(1, options.prefault_threads));
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (addr_ != nullptr) {
+        ::munmap(addr_, size_);
+    }
+}
+
+void MappedFile::prefault(size_t offset, size_t length, size_t num_threads) const {
+    if (offset >= size_ || length == 0) {
+        return;
+    }
+    length = std::min(length, size_ - offset);
+
+    const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    uint8_t* base = static_cast<uint8_t*>(addr_);
+    size_t begin = offset / page_size * page_size;
+    size_t end = offset + length;
+
+    // Give every thread at least a few MB so small files don't pay for thread startup
+    constexpr size_t kMinSliceBytes = 4 << 20;
+    size_t total = end - begin;
+    num_threads = std::max<size_t>(1, std::min(num_threads, total / kMinSliceBytes));
+    size_t slice = alignUp((total + num_threads - 1) / num_threads, page_size);
+
+    auto touch = [&](size_t slice_begin, size_t slice_end) {
+        // MADV_POPULATE_READ (Linux 5.14+) faults the range without user-space loads
+        if (::madvise(base + slice_begin, slice_end - slice_begin, MADV_POPULATE_READ) == 0) {
+            return;
+        }
+        volatile uint8_t sink = 0;
+        for (size_t page = slice_begin; page < slice_end; page += page_size) {
+            sink = sink + base[page];
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        size_t slice_begin = begin + t * slice;
+        if (slice_begin >= end) {
+            break;
+        }
+        threads.emplace_back(touch, slice_begin, std::min(end, slice_begin + slice));
+    }
+    touch(begin, std::min(end, begin + slice));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// TensorFile
+
+std::shared_ptr<TensorFile> TensorFile::open(const std::string& path, const MapOptions& options) {
+    std::shared_ptr<TensorFile> file(new TensorFile());
+    file->file_ = MappedFile::open(path, options);
+    file->parse();
+    return file;
+}
+
+std::shared_ptr<TensorFile> TensorFile::openShared(const std::string& path,
+                                                   const MapOptions& options) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<TensorFile>> open_files;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = open_files.find(path);
+    if (it != open_files.end()) {
+        // A file written over the path is a new inode; tensors still using
+        // the old mapping keep it, new opens map the new file
+        auto file = it->second.lock();
+        if (file && file->file_->isCurrent()) {
+            file->file_->advise(options);
+            return file;
+        }
+    }
+    auto file = open(path, options);
+    open_files[path] = file;
+    return file;
+}
+
+void TensorFile::parse() {
+    const uint8_t* base = file_->data();
+    const size_t size = file_->size();
+    const std::string& path = file_->path();
+
+    if (size < sizeof(FileHeader)) {
+        throw std::runtime_error("Truncated tensor file '" + path + "'");
+    }
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kTensorFileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a tensor file '" + path + "'");
+    }
+    if (header.version != kTensorFileVersion) {
+        throw std::runtime_error("Unsupported tensor file version in '" + path + "'");
+    }
+    if (header.file_size != size ||
+        header.tensor_count > size / sizeof(IndexEntry) ||
+        !fitsWithin(header.index_offset, header.tensor_count * sizeof(IndexEntry), size) ||
+        !fitsWithin(header.names_offset, header.names_size, size)) {
+        throw std::runtime_error("Corrupt tensor file header in '" + path + "'");
+    }
+
+    const char* names = reinterpret_cast<const char*>(base + header.names_offset);
+    views_.reserve(header.tensor_count);
+    for (uint64_t i = 0; i < header.tensor_count; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, base + header.index_offset + i * sizeof(IndexEntry), sizeof(entry));
+
+        // The payload must be exactly what the shape and type describe;
+        // readers allocate from the shape and copy data_size bytes
+        uint64_t expected_size = 0;
+        if (entry.ndim > kMaxTensorDims ||
+            entry.dtype > static_cast<uint32_t>(DataType::BOOL) ||
+            !expectedPayloadSize(entry, expected_size) ||
+            entry.data_size != expected_size ||
+            !fitsWithin(entry.name_offset, entry.name_length, header.names_size) ||
+            entry.data_offset % kPayloadAlignment != 0 ||
+            !fitsWithin(entry.data_offset, entry.data_size, size)) {
+            throw std::runtime_error("Corrupt tensor file index in '" + path + "'");
+        }
+
+        const uint32_t* checksums = nullptr;
+        if ((header.flags & kFlagChunkChecksums) && entry.checksum_offset != 0) {
+            uint64_t chunks = entry.chunk_size == 0
+                ? 0 : (entry.data_size + entry.chunk_size - 1) / entry.chunk_size;
+            if (entry.chunk_size == 0 || entry.checksum_offset % alignof(uint32_t) != 0 ||
+                chunks > size / sizeof(uint32_t) ||
+                !fitsWithin(entry.checksum_offset, chunks * sizeof(uint32_t), size)) {
+                throw std::runtime_error("Corrupt tensor file checksums in '" + path + "'");
+            }
+            checksums = reinterpret_cast<const uint32_t*>(base + entry.checksum_offset);
+        }
+
+        TensorView view;
+        view.name.assign(names + entry.name_offset, entry.name_length);
+        view.shape.assign(entry.shape, entry.shape + entry.ndim);
+        view.dtype = static_cast<DataType>(entry.dtype);
+        view.data = base + entry.data_offset;
+        view.size = entry.data_size;
+        view.offset = entry.data_offset;
+        view.checksums = checksums;
+        view.chunk_size = checksums ? entry.chunk_size : 0;
+
+        lookup_.emplace(view.name, views_.size());
+        views_.push_back(std::move(view));
+    }
+}
+
+bool TensorFile::contains(const std::string& name) const {
+    return lookup_.count(name) != 0;
+}
+
+const TensorView& TensorFile::find(const std::string& name) const {
+    auto it = lookup_.find(name);
+    if (it == lookup_.end()) {
+        throw std::invalid_argument("Tensor '" + name + "' not found in '" + file_->path() + "'");
+    }
+    return views_[it->second];
+}
+
+// TensorFileWriter
+
+void TensorFileWriter::addTensor(const std::string& name,
+                                 const std::vector<size_t>& shape,
+                                 DataType dtype,
+                                 const void* data) {
+    if (shape.size() > kMaxTensorDims) {
+        throw std::invalid_argument("Tensor '" + name + "' has too many dimensions");
+    }
+    size_t size = dataTypeSize(dtype);
+    for (size_t dim : shape) {
+        size *= dim;
+    }
+    pending_.push_back({name, shape, dtype, data, size});
+}
+
+void TensorFileWriter::addTensor(const std::string& name, const Tensor& tensor) {
+    Device& device = tensor.getDevice();
+    if (device.getType() == DeviceType::CPU) {
+        addTensor(name, tensor.getShape(), tensor.getDataType(), tensor.data<uint8_t>());
+        return;
+    }
+
+    // pwrite cannot read device addresses
+    size_t size = tensor.getSize() * dataTypeSize(tensor.getDataType());
+    auto staging = std::make_shared<std::vector<uint8_t>>(size);
+    TensorScope scope;
+    core::MemoryManager::getInstance().copyDeviceToHost(
+        staging->data(), tensor.data<uint8_t>(), size, device);
+    addTensor(name, tensor.getShape(), tensor.getDataType(), staging->data());
+    staging_.push_back(std::move(staging));
+}
+
+void TensorFileWriter::write(const std::string& path, const WriteOptions& options) const {
+    if (options.chunk_size == 0 || options.chunk_size % kPayloadAlignment != 0) {
+        throw std::invalid_argument("Chunk size must be a positive multiple of 64 bytes");
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kTensorFileMagic, sizeof(header.magic));
+    header.version = kTensorFileVersion;
+    header.flags = options.checksums ? kFlagChunkChecksums : 0;
+    header.tensor_count = pending_.size();
+    header.index_offset = sizeof(FileHeader);
+    header.names_offset = header.index_offset + pending_.size() * sizeof(IndexEntry);
+
+    std::vector<IndexEntry> index(pending_.size());
+    std::string names;
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        index[i].name_offset = names.size();
+        index[i].name_length = static_cast<uint32_t>(pending_[i].name.size());
+        names += pending_[i].name;
+    }
+    header.names_size = names.size();
+
+    // Checksum tables sit between the names and the first payload
+    struct Chunk {
+        size_t tensor;
+        size_t index;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<size_t> first_checksum(pending_.size());
+    uint64_t offset = alignUp(header.names_offset + header.names_size, alignof(uint32_t));
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        size_t num_chunks = (pending_[i].size + options.chunk_size - 1) / options.chunk_size;
+        first_checksum[i] = chunks.size();
+        for (size_t c = 0; c < num_chunks; ++c) {
+            chunks.push_back({i, c});
+        }
+        if (options.checksums) {
+            index[i].checksum_offset = offset;
+            index[i].chunk_size = options.chunk_size;
+            offset += num_chunks * sizeof(uint32_t);
+        }
+    }
+    std::vector<uint32_t> checksums(options.checksums ? chunks.size() : 0);
+
+    offset = alignUp(offset, kPayloadAlignment);
+    header.data_offset = offset;
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        const auto& tensor = pending_[i];
+        IndexEntry& entry = index[i];
+        entry.dtype = static_cast<uint32_t>(tensor.dtype);
+        entry.ndim = static_cast<uint32_t>(tensor.shape.size());
+        std::copy(tensor.shape.begin(), tensor.shape.end(), entry.shape);
+        entry.data_offset = offset;
+        entry.data_size = tensor.size;
+        offset = alignUp(offset + tensor.size, kPayloadAlignment);
+    }
+    header.file_size = offset;
+
+    // Unique per process and call, so concurrent writers never share a file
+    static std::atomic<uint64_t> sequence{0};
+    std::string temp_path = path + ".tmp." + std::to_string(::getpid()) + "." +
+                            std::to_string(sequence.fetch_add(1, std::memory_order_relaxed));
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Failed to create tensor file", temp_path);
+    }
+    try {
+        // Size the file up front; alignment gaps then read back as zeros
+        if (::ftruncate(fd, static_cast<off_t>(header.file_size)) != 0) {
+            throw ioError("Failed to size tensor file", temp_path);
+        }
+
+        // Payload chunks go out in parallel, each checksummed while still cache hot
+        parallelFor(chunks.size(), options.num_threads, [&](size_t i) {
+            const Chunk& chunk = chunks[i];
+            const PendingTensor& tensor = pending_[chunk.tensor];
+            size_t begin = chunk.index * options.chunk_size;
+            size_t length = std::min(options.chunk_size, tensor.size - begin);
+            const uint8_t* data = static_cast<const uint8_t*>(tensor.data) + begin;
+            if (options.checksums) {
+                checksums[i] = crc32c(data, length);
+            }
+            writeFully(fd, data, length, index[chunk.tensor].data_offset + begin, temp_path);
+        });
+
+        for (size_t i = 0; options.checksums && i < pending_.size(); ++i) {
+            size_t num_chunks = (pending_[i].size + options.chunk_size - 1) / options.chunk_size;
+            writeFully(fd, checksums.data() + first_checksum[i], num_chunks * sizeof(uint32_t),
+                       index[i].checksum_offset, temp_path);
+        }
+        writeFully(fd, names.data(), names.size(), header.names_offset, temp_path);
+        writeFully(fd, index.data(), index.size() * sizeof(IndexEntry),
+                   header.index_offset, temp_path);
+        writeFully(fd, &header, sizeof(header), 0, temp_path);
+
+        if (options.sync && ::fsync(fd) != 0) {
+            throw ioError("Failed to sync tensor file", temp_path);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temp_path.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        ::unlink(temp_path.c_str());
+        throw ioError("Failed to publish tensor file", path);
+    }
+    if (options.sync) {
+        syncParentDirectory(path);
+    }
+}
+
+} // namespace io
+
+// Tensor::mapFile
+
+std::shared_ptr<const Tensor> Tensor::mapFile(const std::string& path,
+                                              const std::string& name,
+                                              Device& device,
+                                              const MapOptions& options) {
+    auto file = io::TensorFile::openShared(path, options);
+    const io::TensorView& view = file->find(name);
+
+    if (device.getType() == DeviceType::CPU) {
+        // Aliasing pointer: the tensor keeps the reader, and so the shared
+        // mapping, alive; later mapFile calls on the path reuse it
+        std::shared_ptr<const void> storage(file, view.data);
+        return Tensor::wrap(view.shape, view.dtype, device, std::move(storage));
+    }
+
+    // Device memory is not host addressable, upload straight from the page cache
+    auto tensor = Tensor::create(view.shape, view.dtype, device);
+    TensorScope scope;
+    core::MemoryManager::getInstance().copyHostToDevice(
+        tensor->data<uint8_t>(), view.data, view.size, device);
+    return tensor;
+}
+
+} // namespace uta
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <uta/uta.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sys/types.h>
+#include <time.h>
+
+namespace uta {
+namespace io {
+
+// On-disk tensor container
+//
+//   [FileHeader][IndexEntry * tensor_count][name table][checksum tables]
+//   [pad][payload 0][pad][payload 1]...
+//
+// Every payload starts on a kPayloadAlignment boundary so that a mapped file
+// can be handed out as tensor storage without any copy. Files written with
+// checksums carry one CRC32C per chunk_size bytes of each payload.
+constexpr char kTensorFileMagic[8] = {'U', 'T', 'A', 'T', 'E', 'N', 'S', '\0'};
+constexpr uint32_t kTensorFileVersion = 1;
+constexpr size_t kPayloadAlignment = 64;
+constexpr size_t kMaxTensorDims = 8;
+constexpr uint32_t kFlagChunkChecksums = 1u << 0;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t tensor_count;
+    uint64_t index_offset;      // offset of the first IndexEntry
+    uint64_t names_offset;      // offset of the name table
+    uint64_t names_size;
+    uint64_t data_offset;       // offset of the first payload
+    uint64_t file_size;
+};
+
+struct IndexEntry {
+    uint64_t name_offset;       // relative to FileHeader::names_offset
+    uint32_t name_length;
+    uint32_t dtype;             // uta::DataType
+    uint32_t ndim;
+    uint32_t flags;
+    uint64_t shape[kMaxTensorDims];
+    uint64_t data_offset;       // absolute, kPayloadAlignment aligned
+    uint64_t data_size;         // bytes
+    uint64_t checksum_offset;   // absolute offset of uint32_t[chunks], 0 if none
+    uint64_t chunk_size;        // bytes covered by one checksum
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+static_assert(sizeof(IndexEntry) == 128, "IndexEntry layout changed");
+
+// Size in bytes of one element of the given type
+size_t dataTypeSize(DataType dtype);
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Read-only view of one tensor inside a mapped file
+struct TensorView {
+    std::string name;
+    std::vector<size_t> shape;
+    DataType dtype;
+    const void* data;
+    size_t size;                // bytes
+    uint64_t offset;            // payload offset in the file
+    const uint32_t* checksums;  // one per chunk, nullptr if the file has none
+    size_t chunk_size;
+
+    size_t numChunks() const {
+        return chunk_size == 0 ? 0 : (size + chunk_size - 1) / chunk_size;
+    }
+};
+
+// Runs fn(0..count-1) on up to num_threads threads (0 = hardware concurrency)
+// and rethrows the first exception once all threads have stopped
+void parallelFor(size_t count, size_t num_threads, const std::function<void(size_t)>& fn);
+
+// mmap'd file region
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> open(const std::string& path, const MapOptions& options);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(addr_); }
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+    // Touch every page of [offset, offset + length) from num_threads threads
+    void prefault(size_t offset, size_t length, size_t num_threads) const;
+
+    // True while path still names the mapped file, unchanged since it was mapped
+    bool isCurrent() const;
+
+    // Applies map-time options to an existing mapping
+    void advise(const MapOptions& options) const;
+
+private:
+    MappedFile() = default;
+
+    std::string path_;
+    void* addr_{nullptr};
+    size_t size_{0};
+    dev_t device_{0};
+    ino_t inode_{0};
+    timespec mtime_{};
+};
+
+// Reader over a mapped tensor file
+class TensorFile {
+public:
+    static std::shared_ptr<TensorFile> open(const std::string& path,
+                                            const MapOptions& options = MapOptions());
+
+    // Shared mapping per path; later opens reuse a still-live mapping of the
+    // same file, or map the path again once it has been replaced
+    static std::shared_ptr<TensorFile> openShared(const std::string& path,
+                                                  const MapOptions& options = MapOptions());
+
+    bool contains(const std::string& name) const;
+    const TensorView& find(const std::string& name) const;
+    const std::vector<TensorView>& tensors() const { return views_; }
+
+    // Keeps the mapping alive for as long as a tensor points into it
+    std::shared_ptr<MappedFile> mapping() const { return file_; }
+
+private:
+    TensorFile() = default;
+
+    void parse();
+
+    std::shared_ptr<MappedFile> file_;
+    std::vector<TensorView> views_;
+    std::unordered_map<std::string, size_t> lookup_;
+};
+
+// Tensor file write options
+struct WriteOptions {
+    size_t chunk_size = 64 << 20;   // unit of parallel writes and checksums
+    size_t num_threads = 0;         // 0 = hardware concurrency
+    bool checksums = true;
+    bool sync = true;               // fsync before publishing
+};
+
+// Writer for the tensor container
+class TensorFileWriter {
+public:
+    // Registers a tensor; data must stay valid until write() returns
+    void addTensor(const std::string& name,
+                   const std::vector<size_t>& shape,
+                   DataType dtype,
+                   const void* data);
+
+    // Device tensors are copied to host memory here, host tensors are
+    // written from their storage and must not change until write() returns
+    void addTensor(const std::string& name, const Tensor& tensor);
+
+    // Writes chunks in parallel to a temporary file and renames it over path
+    void write(const std::string& path, const WriteOptions& options = WriteOptions()) const;
+
+    size_t size() const { return pending_.size(); }
+
+private:
+    struct PendingTensor {
+        std::string name;
+        std::vector<size_t> shape;
+        DataType dtype;
+        const void* data;
+        size_t size;
+    };
+
+    std::vector<PendingTensor> pending_;
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> staging_;   // host copies of device tensors
+};
+
+} // namespace io
+} // namespace uta
@@ -0,0 +1,538 @@
+#include "memory_budget.hpp"
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+namespace uta {
+namespace core {
+
+namespace {
+
+enum BufferState : int {
+    RESIDENT,
+    EVICTING,
+    SPILLED
+};
+
+// Refetch cost model per tier: fixed latency plus bytes over bandwidth
+constexpr double kHostRefetchLatency = 10e-6;
+constexpr double kHostRefetchBandwidth = 12e9;
+constexpr double kFileRefetchLatency = 200e-6;
+constexpr double kFileRefetchBandwidth = 2e9;
+
+// Pool allocation granularity, enough for any device load
+constexpr size_t kPoolAlignment = 256;
+
+// Fragmentation at which a device pool compacts at its safe points
+constexpr double kCompactionThreshold = 0.25;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double refetchSeconds(SpillTier tier, size_t size) {
+    if (tier == SpillTier::HOST) {
+        return kHostRefetchLatency + static_cast<double>(size) / kHostRefetchBandwidth;
+    }
+    return kFileRefetchLatency + static_cast<double>(size) / kFileRefetchBandwidth;
+}
+
+void* allocateHost(size_t size) {
+    void* ptr = std::aligned_alloc(64, (std::max<size_t>(size, 1) + 63) / 64 * 64);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+} // namespace
+
+class MemoryBudget::Buffer {
+public:
+    DeviceKey device;
+    size_t size;
+    std::atomic<int> state{RESIDENT};
+    std::atomic<uint32_t> pins{0};
+    std::atomic<int64_t> last_access{0};
+    void* device_ptr{nullptr};
+
+    // Resident in a pool instead of at device_ptr
+    DevicePool* pool{nullptr};
+    DevicePool::Handle block{nullptr};
+
+    // Device address of a resident buffer, held in place against pool
+    // compaction until unpinDevice()
+    void* pinDevice() { return block != nullptr ? pool->acquire(block) : device_ptr; }
+    void unpinDevice() {
+        if (block != nullptr) {
+            pool->release(block);
+        }
+    }
+
+    // Spilled copy
+    SpillTier tier{SpillTier::HOST};
+    void* host_copy{nullptr};
+    int spill_fd{-1};
+};
+
+struct MemoryBudget::DeviceBudget {
+    DeviceKey key;
+    BudgetConfig config;
+    std::unique_ptr<DevicePool> pool;
+    mutable std::mutex mutex;
+    std::unordered_map<Buffer*, std::unique_ptr<Buffer>> buffers;
+    BudgetStats stats{};
+};
+
+MemoryBudget& MemoryBudget::getInstance() {
+    static MemoryBudget instance;
+    return instance;
+}
+
+void MemoryBudget::configure(DeviceKey key, const BudgetConfig& config) {
+    if (key.type == DeviceType::CPU) {
+        throw std::invalid_argument("Host memory has no device memory budget");
+    }
+    BudgetConfig resolved = config;
+    if (!resolved.ops.allocate) {
+        resolved.ops.allocate = allocateHost;
+    }
+    if (!resolved.ops.free) {
+        resolved.ops.free = [](void* ptr, size_t) { std::free(ptr); };
+    }
+    if (!resolved.ops.copy_to_host) {
+        resolved.ops.copy_to_host = [](void* dst, const void* src, size_t size) {
+            std::memcpy(dst, src, size);
+        };
+    }
+    if (!resolved.ops.copy_from_host) {
+        resolved.ops.copy_from_host = resolved.ops.copy_to_host;
+    }
+    if (!resolved.ops.move) {
+        resolved.ops.move = [](void* dst, const void* src, size_t size) {
+            std::memmove(dst, src, size);
+        };
+    }
+
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    auto& device = devices_[key];
+    if (!device) {
+        device = std::make_unique<DeviceBudget>();
+        device->key = key;
+    }
+    std::lock_guard<std::mutex> device_lock(device->mutex);
+    if (!device->pool && resolved.pool_capacity > 0) {
+        DevicePool::PoolConfig pool{};
+        pool.capacity = resolved.pool_capacity;
+        pool.alignment = kPoolAlignment;
+        pool.compaction_threshold = resolved.compaction_threshold;
+        pool.ops.allocate = resolved.ops.allocate;
+        pool.ops.free = resolved.ops.free;
+        pool.ops.move = resolved.ops.move;
+        device->pool = std::make_unique<DevicePool>(pool);
+    }
+    device->config = std::move(resolved);
+    device->stats.memory_limit = device->config.memory_limit;
+}
+
+void MemoryBudget::configure(const DeviceConfig& config, const DeviceOps& ops) {
+    // Host tensors are never budgeted, and without a limit nothing is ever
+    // evicted, so a budget would only force TensorScopes on callers
+    DeviceKey key{config.type, config.device_id};
+    if (config.type == DeviceType::CPU ||
+        (config.memory_limit == 0 && !isConfigured(key))) {
+        return;
+    }
+    BudgetConfig budget{};
+    budget.memory_limit = config.memory_limit;
+    budget.host_spill_limit = config.host_spill_limit == 0 ? SIZE_MAX : config.host_spill_limit;
+    budget.spill_dir = config.spill_dir;
+    budget.pool_capacity = config.memory_limit;
+    budget.compaction_threshold = kCompactionThreshold;
+    budget.ops = ops;
+    // An existing budget keeps serving the buffers it already manages
+    configure(key, budget);
+    if (config.memory_limit > 0) {
+        // Shrinking the limit below current usage evicts right away
+        trim(key, config.memory_limit);
+    }
+}
+
+bool MemoryBudget::isConfigured(DeviceKey key) const {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    return devices_.count(key) != 0;
+}
+
+bool MemoryBudget::isLimited(DeviceKey key) const {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    auto it = devices_.find(key);
+    if (it == devices_.end()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> device_lock(it->second->mutex);
+    return it->second->config.memory_limit != 0;
+}
+
+MemoryBudget::DeviceBudget& MemoryBudget::getDevice(DeviceKey key) const {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    auto it = devices_.find(key);
+    if (it == devices_.end()) {
+        throw std::invalid_argument("No memory budget configured for device " +
+                                    std::to_string(key.id));
+    }
+    return *it->second;
+}
+
+MemoryBudget::BufferHandle MemoryBudget::allocate(DeviceKey key, size_t size) {
+    DeviceBudget& device = getDevice(key);
+    auto buffer = std::make_unique<Buffer>();
+    buffer->device = key;
+    buffer->size = size;
+    buffer->last_access.store(nowNs(), std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(device.mutex);
+    makeRoom(device, size, nullptr);
+    try {
+        allocateDevice(device, *buffer, nullptr);
+    } catch (...) {
+        device.stats.resident_bytes -= size;
+        throw;
+    }
+
+    Buffer* handle = buffer.get();
+    device.buffers.emplace(handle, std::move(buffer));
+    return handle;
+}
+
+void MemoryBudget::free(BufferHandle buffer) {
+    DeviceBudget& device = getDevice(buffer->device);
+    std::lock_guard<std::mutex> lock(device.mutex);
+
+    if (buffer->state.load() == RESIDENT) {
+        freeDevice(device, *buffer);
+        device.stats.resident_bytes -= buffer->size;
+    } else if (buffer->tier == SpillTier::HOST) {
+        std::free(buffer->host_copy);
+        device.stats.host_spilled_bytes -= buffer->size;
+    } else {
+        ::close(buffer->spill_fd);
+        device.stats.file_spilled_bytes -= buffer->size;
+    }
+    device.buffers.erase(buffer);
+}
+
+void* MemoryBudget::acquire(BufferHandle buffer) {
+    // Fast path: pin, then confirm no eviction is in progress. Paired with the
+    // EVICTING store / pins load in evict(), one side always sees the other.
+    buffer->pins.fetch_add(1);
+    if (buffer->state.load() == RESIDENT) {
+        buffer->last_access.store(nowNs(), std::memory_order_relaxed);
+        return buffer->pinDevice();
+    }
+
+    DeviceBudget& device = getDevice(buffer->device);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    if (buffer->state.load() == SPILLED) {
+        try {
+            faultIn(device, *buffer);
+        } catch (...) {
+            buffer->pins.fetch_sub(1);
+            throw;
+        }
+    }
+    buffer->last_access.store(nowNs(), std::memory_order_relaxed);
+    return buffer->pinDevice();
+}
+
+void MemoryBudget::release(BufferHandle buffer) {
+    buffer->last_access.store(nowNs(), std::memory_order_relaxed);
+    // Still pinned here, so the buffer cannot be evicted under us
+    buffer->unpinDevice();
+    buffer->pins.fetch_sub(1, std::memory_order_release);
+}
+
+bool MemoryBudget::isResident(BufferHandle buffer) const {
+    return buffer->state.load(std::memory_order_acquire) == RESIDENT;
+}
+
+size_t MemoryBudget::getSize(BufferHandle buffer) const {
+    return buffer->size;
+}
+
+void MemoryBudget::reserve(DeviceKey key, size_t size) {
+    DeviceBudget& device = getDevice(key);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    makeRoom(device, size, nullptr);
+    device.stats.reserved_bytes += size;
+}
+
+void MemoryBudget::unreserve(DeviceKey key, size_t size) {
+    DeviceBudget& device = getDevice(key);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    size = std::min(size, device.stats.reserved_bytes);
+    device.stats.reserved_bytes -= size;
+    device.stats.resident_bytes -= size;
+}
+
+void MemoryBudget::trim(DeviceKey key, size_t target_bytes) {
+    DeviceBudget& device = getDevice(key);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    while (device.stats.resident_bytes > target_bytes &&
+           evictOne(device, device.stats.resident_bytes - target_bytes, nullptr)) {
+    }
+}
+
+MemoryBudget::BudgetStats MemoryBudget::getStats(DeviceKey key) const {
+    DeviceBudget& device = getDevice(key);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    return device.stats;
+}
+
+DevicePool* MemoryBudget::getPool(DeviceKey key) const {
+    DeviceBudget& device = getDevice(key);
+    std::lock_guard<std::mutex> lock(device.mutex);
+    return device.pool.get();
+}
+
+void MemoryBudget::allocateDevice(DeviceBudget& device, Buffer& buffer, BufferHandle keep) {
+    if (!device.pool) {
+        buffer.device_ptr = device.config.ops.allocate(buffer.size);
+        return;
+    }
+    for (;;) {
+        try {
+            buffer.block = device.pool->allocate(buffer.size);
+            buffer.pool = device.pool.get();
+            return;
+        } catch (const std::runtime_error&) {
+            // The pool is full or split; compaction waits for a safe point,
+            // so evict until the buffer fits
+        }
+        if (device.config.memory_limit == 0) {
+            // The limit was lifted; the pool no longer bounds the device
+            buffer.device_ptr = device.config.ops.allocate(buffer.size);
+            return;
+        }
+        if (!evictOne(device, buffer.size, keep)) {
+            throw outOfMemory(device, buffer.size);
+        }
+    }
+}
+
+void MemoryBudget::freeDevice(DeviceBudget& device, Buffer& buffer) {
+    if (buffer.block != nullptr) {
+        device.pool->free(buffer.block);
+        buffer.block = nullptr;
+    } else {
+        device.config.ops.free(buffer.device_ptr, buffer.size);
+        buffer.device_ptr = nullptr;
+    }
+}
+
+void MemoryBudget::makeRoom(DeviceBudget& device, size_t size, BufferHandle keep) {
+    const size_t limit = device.config.memory_limit;
+    if (limit != 0) {
+        if (size > limit) {
+            throw std::runtime_error("Allocation of " + std::to_string(size) +
+                                     " bytes exceeds the memory limit of device " +
+                                     std::to_string(device.key.id));
+        }
+        while (device.stats.resident_bytes + size > limit) {
+            size_t deficit = device.stats.resident_bytes + size - limit;
+            if (!evictOne(device, deficit, keep)) {
+                throw outOfMemory(device, size);
+            }
+        }
+    }
+    device.stats.resident_bytes += size;
+    device.stats.peak_resident_bytes =
+        std::max(device.stats.peak_resident_bytes, device.stats.resident_bytes);
+}
+
+std::runtime_error MemoryBudget::outOfMemory(const DeviceBudget& device, size_t size) const {
+    // Whatever is resident and neither reserved nor pinned had no spill space left
+    size_t pinned = 0;
+    size_t unspillable = 0;
+    for (const auto& entry : device.buffers) {
+        const Buffer* buffer = entry.first;
+        if (buffer->state.load() != SPILLED) {
+            (buffer->pins.load() != 0 ? pinned : unspillable) += buffer->size;
+        }
+    }
+    return std::runtime_error(
+        "Out of memory on device " + std::to_string(device.key.id) + ": " +
+        std::to_string(size) + " bytes requested, limit " +
+        std::to_string(device.config.memory_limit) + ", resident " +
+        std::to_string(device.stats.reserved_bytes) + " reserved, " +
+        std::to_string(pinned) + " pinned, " +
+        std::to_string(unspillable) + " with no spill space");
+}
+
+bool MemoryBudget::evictOne(DeviceBudget& device, size_t deficit, BufferHandle keep) {
+    const int64_t now = nowNs();
+    const bool file_tier = !device.config.spill_dir.empty();
+
+    // Approximate LRU weighted by cost: favour buffers that have been idle long,
+    // cover much of the deficit, and are cheap to bring back.
+    Buffer* victim = nullptr;
+    SpillTier victim_tier = SpillTier::HOST;
+    double best_score = -1.0;
+    for (auto& entry : device.buffers) {
+        Buffer* buffer = entry.first;
+        if (buffer == keep || buffer->state.load() != RESIDENT || buffer->pins.load() != 0) {
+            continue;
+        }
+        SpillTier tier;
+        if (device.stats.host_spilled_bytes + buffer->size <= device.config.host_spill_limit) {
+            tier = SpillTier::HOST;
+        } else if (file_tier) {
+            tier = SpillTier::FILE;
+        } else {
+            continue;
+        }
+        double idle = static_cast<double>(now - buffer->last_access.load(std::memory_order_relaxed)) * 1e-9;
+        double reclaimed = static_cast<double>(std::min(buffer->size, deficit));
+        double score = (idle + 1e-6) * reclaimed / refetchSeconds(tier, buffer->size);
+        if (score > best_score) {
+            best_score = score;
+            victim = buffer;
+            victim_tier = tier;
+        }
+    }
+
+    if (victim == nullptr) {
+        return false;
+    }
+    evict(device, *victim, victim_tier);
+    return victim->state.load() == SPILLED || evictOne(device, deficit, keep);
+}
+
+void MemoryBudget::evict(DeviceBudget& device, Buffer& buffer, SpillTier tier) {
+    buffer.state.store(EVICTING);
+    if (buffer.pins.load() != 0) {
+        // Lost the race against acquire()
+        buffer.state.store(RESIDENT);
+        return;
+    }
+
+    // Held in place for the copy out; a pool safe point may run meanwhile
+    void* data = buffer.pinDevice();
+    if (tier == SpillTier::HOST) {
+        try {
+            buffer.host_copy = allocateHost(buffer.size);
+            device.config.ops.copy_to_host(buffer.host_copy, data, buffer.size);
+        } catch (...) {
+            // The device copy is untouched; keep using it
+            buffer.unpinDevice();
+            std::free(buffer.host_copy);
+            buffer.host_copy = nullptr;
+            buffer.state.store(RESIDENT);
+            throw;
+        }
+        device.stats.host_spilled_bytes += buffer.size;
+    } else {
+        std::string pattern = device.config.spill_dir + "/uta_spill_XXXXXX";
+        int fd = ::mkstemp(&pattern[0]);
+        if (fd < 0) {
+            buffer.unpinDevice();
+            buffer.state.store(RESIDENT);
+            throw std::runtime_error("Failed to create spill file in '" +
+                                     device.config.spill_dir + "': " + std::strerror(errno));
+        }
+        ::unlink(pattern.c_str());
+
+        // Stage through a bounded host buffer so device memory need not be mapped
+        constexpr size_t kStageBytes = 8 << 20;
+        try {
+            std::vector<uint8_t> stage(std::min(buffer.size, kStageBytes));
+            for (size_t offset = 0; offset < buffer.size; offset += stage.size()) {
+                size_t length = std::min(stage.size(), buffer.size - offset);
+                device.config.ops.copy_to_host(stage.data(),
+                                               static_cast<uint8_t*>(data) + offset,
+                                               length);
+                if (::pwrite(fd, stage.data(), length, static_cast<off_t>(offset)) !=
+                    static_cast<ssize_t>(length)) {
+                    throw std::runtime_error("Failed to write spill file: " +
+                                             std::string(std::strerror(errno)));
+                }
+            }
+        } catch (...) {
+            buffer.unpinDevice();
+            ::close(fd);
+            buffer.state.store(RESIDENT);
+            throw;
+        }
+        buffer.spill_fd = fd;
+        device.stats.file_spilled_bytes += buffer.size;
+    }
+
+    buffer.unpinDevice();
+    freeDevice(device, buffer);
+    buffer.tier = tier;
+    device.stats.resident_bytes -= buffer.size;
+    device.stats.evictions++;
+    device.stats.bytes_evicted += buffer.size;
+    buffer.state.store(SPILLED);
+}
+
+void MemoryBudget::faultIn(DeviceBudget& device, Buffer& buffer) {
+    makeRoom(device, buffer.size, &buffer);
+    try {
+        allocateDevice(device, buffer, &buffer);
+    } catch (...) {
+        device.stats.resident_bytes -= buffer.size;
+        throw;
+    }
+
+    void* ptr = buffer.pinDevice();
+    try {
+        if (buffer.tier == SpillTier::HOST) {
+            device.config.ops.copy_from_host(ptr, buffer.host_copy, buffer.size);
+        } else {
+            constexpr size_t kStageBytes = 8 << 20;
+            std::vector<uint8_t> stage(std::min(buffer.size, kStageBytes));
+            for (size_t offset = 0; offset < buffer.size; offset += stage.size()) {
+                size_t length = std::min(stage.size(), buffer.size - offset);
+                if (::pread(buffer.spill_fd, stage.data(), length, static_cast<off_t>(offset)) !=
+                    static_cast<ssize_t>(length)) {
+                    throw std::runtime_error("Failed to read spill file: " +
+                                             std::string(std::strerror(errno)));
+                }
+                device.config.ops.copy_from_host(static_cast<uint8_t*>(ptr) + offset,
+                                                 stage.data(), length);
+            }
+        }
+    } catch (...) {
+        // The spilled copy is untouched; the buffer stays spilled
+        buffer.unpinDevice();
+        freeDevice(device, buffer);
+        device.stats.resident_bytes -= buffer.size;
+        throw;
+    }
+    buffer.unpinDevice();
+
+    if (buffer.tier == SpillTier::HOST) {
+        std::free(buffer.host_copy);
+        buffer.host_copy = nullptr;
+        device.stats.host_spilled_bytes -= buffer.size;
+    } else {
+        ::close(buffer.spill_fd);
+        buffer.spill_fd = -1;
+        device.stats.file_spilled_bytes -= buffer.size;
+    }
+
+    device.stats.faults++;
+    device.stats.bytes_faulted += buffer.size;
+    buffer.state.store(RESIDENT);
+}
+
+} // namespace core
+} // namespace uta
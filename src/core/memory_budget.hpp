@@ -0,0 +1,141 @@
+#pragma once
+
+#include <uta/uta.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace uta {
+namespace core {
+
+class DevicePool;
+
+// Budgets are per device; ids are only unique within a device type
+struct DeviceKey {
+    DeviceType type;
+    int id;
+
+    bool operator<(const DeviceKey& other) const {
+        return type != other.type ? type < other.type : id < other.id;
+    }
+};
+
+// Where an evicted buffer lives until it is faulted back
+enum class SpillTier {
+    HOST,       // pageable host memory
+    FILE        // unlinked temporary file under BudgetConfig::spill_dir
+};
+
+// Per-device memory budget with spill-to-host/disk eviction
+//
+// Buffers allocated through the budget are reached through a handle. acquire()
+// pins a buffer and returns its current device address, faulting it back in if
+// it was evicted; release() unpins it. When an allocation would exceed the
+// device limit, unpinned buffers are evicted, cheapest-to-lose first.
+//
+// With a pool configured, resident buffers live in a compacting DevicePool
+// (getPool()); unpinned buffers move when the pool reaches a safe point, and
+// an allocation that finds the pool split evicts rather than compacts.
+//
+// Device tensors on a device configured with a memory limit
+// (Device::configure) are managed buffers themselves, pinned for the
+// TensorScope their data() is taken in, in a pool as large as the limit.
+// Host memory has no budget. Memory allocated outside the budget is
+// accounted with reserve().
+class MemoryBudget {
+public:
+    // Device memory primitives used to allocate, evict and fault back buffers
+    struct DeviceOps {
+        std::function<void*(size_t)> allocate;
+        std::function<void(void*, size_t)> free;
+        std::function<void(void*, const void*, size_t)> copy_to_host;     // dst, src, size
+        std::function<void(void*, const void*, size_t)> copy_from_host;   // dst, src, size
+        std::function<void(void*, const void*, size_t)> move;             // device memmove
+    };
+
+    struct BudgetConfig {
+        size_t memory_limit;        // resident device bytes, 0 = unlimited
+        size_t host_spill_limit;    // host tier capacity before spilling to files
+        std::string spill_dir;      // file tier directory, empty disables the tier
+        size_t pool_capacity;       // compacting pool for resident buffers, 0 = none;
+                                    // the first configuration to set it creates the pool
+        double compaction_threshold;    // pool safePoint() compacts above this fragmentation
+        DeviceOps ops;              // unset members fall back to host memory
+    };
+
+    struct BudgetStats {
+        size_t memory_limit;
+        size_t resident_bytes;      // managed buffers and reservations
+        size_t reserved_bytes;
+        size_t peak_resident_bytes;
+        size_t host_spilled_bytes;
+        size_t file_spilled_bytes;
+        size_t evictions;
+        size_t faults;
+        size_t bytes_evicted;
+        size_t bytes_faulted;
+    };
+
+    class Buffer;
+    using BufferHandle = Buffer*;
+
+    static MemoryBudget& getInstance();
+
+    // Budget configuration. A DeviceConfig without a memory limit registers
+    // no budget and lifts the limit of an existing one
+    void configure(DeviceKey device, const BudgetConfig& config);
+    void configure(const DeviceConfig& config, const DeviceOps& ops = DeviceOps());
+    bool isConfigured(DeviceKey device) const;
+
+    // Whether the device has a budget with a memory limit, so new device
+    // tensors on it are managed buffers
+    bool isLimited(DeviceKey device) const;
+
+    // Managed (evictable) buffers
+    BufferHandle allocate(DeviceKey device, size_t size);
+    void free(BufferHandle buffer);
+    void* acquire(BufferHandle buffer);
+    void release(BufferHandle buffer);
+    bool isResident(BufferHandle buffer) const;
+    size_t getSize(BufferHandle buffer) const;
+
+    // Accounting for memory allocated outside the budget; may evict managed buffers
+    void reserve(DeviceKey device, size_t size);
+    void unreserve(DeviceKey device, size_t size);
+
+    // Evict unpinned buffers until at most target_bytes are resident
+    void trim(DeviceKey device, size_t target_bytes);
+
+    BudgetStats getStats(DeviceKey device) const;
+
+    // Pool holding the device's resident buffers, nullptr without one; pass
+    // it to ExecutableGraph::addSafePoint() to compact between launches
+    DevicePool* getPool(DeviceKey device) const;
+
+private:
+    MemoryBudget() = default;
+
+    struct DeviceBudget;
+
+    DeviceBudget& getDevice(DeviceKey key) const;
+
+    // Called with DeviceBudget::mutex held
+    void makeRoom(DeviceBudget& device, size_t size, BufferHandle keep);
+    std::runtime_error outOfMemory(const DeviceBudget& device, size_t size) const;
+    bool evictOne(DeviceBudget& device, size_t deficit, BufferHandle keep);
+    void evict(DeviceBudget& device, Buffer& buffer, SpillTier tier);
+    void faultIn(DeviceBudget& device, Buffer& buffer);
+    void allocateDevice(DeviceBudget& device, Buffer& buffer, BufferHandle keep);
+    void freeDevice(DeviceBudget& device, Buffer& buffer);
+
+    std::map<DeviceKey, std::unique_ptr<DeviceBudget>> devices_;
+    mutable std::mutex devices_mutex_;
+};
+
+} // namespace core
+} // namespace uta
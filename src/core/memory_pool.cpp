@@ -0,0 +1,273 @@
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace uta {
+namespace core {
+
+namespace {
+
+// Allocation::state layout: pin count in the low bits, MOVING flag on top
+constexpr uint32_t kMovingFlag = 1u << 31;
+
+} // namespace
+
+class DevicePool::Allocation {
+public:
+    std::atomic<uint32_t> state{0};
+    std::atomic<void*> ptr{nullptr};
+    size_t offset;
+    size_t size;
+    bool movable;
+};
+
+DevicePool::DevicePool(const PoolConfig& config)
+    : config_(config)
+{
+    if (config_.alignment == 0 || (config_.alignment & (config_.alignment - 1)) != 0) {
+        throw std::invalid_argument("Pool alignment must be a power of two");
+    }
+    config_.capacity = config_.capacity / config_.alignment * config_.alignment;
+
+    if (!config_.ops.allocate) {
+        const size_t alignment = std::max<size_t>(config_.alignment, sizeof(void*));
+        config_.ops.allocate = [alignment](size_t size) {
+            void* ptr = std::aligned_alloc(alignment, size);
+            if (ptr == nullptr) {
+                throw std::bad_alloc();
+            }
+            return ptr;
+        };
+    }
+    if (!config_.ops.free) {
+        config_.ops.free = [](void* ptr, size_t) { std::free(ptr); };
+    }
+    if (!config_.ops.move) {
+        config_.ops.move = [](void* dst, const void* src, size_t size) {
+            std::memmove(dst, src, size);
+        };
+    }
+
+    base_ = static_cast<uint8_t*>(config_.ops.allocate(config_.capacity));
+    if (config_.capacity > 0) {
+        insertFree(0, config_.capacity);
+    }
+}
+
+DevicePool::~DevicePool() {
+    for (auto& entry : blocks_) {
+        delete entry.second.owner;
+    }
+    config_.ops.free(base_, config_.capacity);
+}
+
+void DevicePool::insertFree(size_t offset, size_t size) {
+    blocks_[offset] = Block{size, nullptr};
+    free_by_size_.emplace(size, offset);
+}
+
+void DevicePool::eraseFree(size_t offset, size_t size) {
+    auto range = free_by_size_.equal_range(size);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == offset) {
+            free_by_size_.erase(it);
+            break;
+        }
+    }
+    blocks_.erase(offset);
+}
+
+bool DevicePool::tryAllocate(size_t size, bool movable, Handle& result) {
+    // Best fit keeps large free regions intact
+    auto it = free_by_size_.lower_bound(size);
+    if (it == free_by_size_.end()) {
+        return false;
+    }
+    size_t block_size = it->first;
+    size_t offset = it->second;
+    free_by_size_.erase(it);
+
+    auto allocation = new Allocation();
+    allocation->offset = offset;
+    allocation->size = size;
+    allocation->movable = movable;
+    allocation->ptr.store(base_ + offset, std::memory_order_release);
+    if (!movable) {
+        // Immovable allocations are permanently pinned
+        allocation->state.store(1, std::memory_order_relaxed);
+    }
+
+    blocks_[offset] = Block{size, allocation};
+    if (block_size > size) {
+        insertFree(offset + size, block_size - size);
+    }
+    used_bytes_ += size;
+    result = allocation;
+    return true;
+}
+
+DevicePool::Handle DevicePool::allocate(size_t size, bool movable, bool compact) {
+    size = std::max(config_.alignment,
+                    (size + config_.alignment - 1) / config_.alignment * config_.alignment);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Handle result = nullptr;
+    if (tryAllocate(size, movable, result)) {
+        return result;
+    }
+    if (compact && config_.capacity - used_bytes_ >= size) {
+        compactLocked();
+        if (tryAllocate(size, movable, result)) {
+            return result;
+        }
+    }
+    throw std::runtime_error("Device pool exhausted: requested " + std::to_string(size) +
+                             " bytes, largest free block is " +
+                             std::to_string(statsLocked().largest_free_block));
+}
+
+void DevicePool::free(Handle allocation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t offset = allocation->offset;
+    size_t size = allocation->size;
+    used_bytes_ -= size;
+    delete allocation;
+
+    // Coalesce with free neighbours
+    auto it = blocks_.find(offset);
+    auto next = std::next(it);
+    if (next != blocks_.end() && next->second.owner == nullptr) {
+        size += next->second.size;
+        eraseFree(next->first, next->second.size);
+    }
+    it = blocks_.find(offset);
+    if (it != blocks_.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second.owner == nullptr) {
+            size_t prev_offset = prev->first;
+            size += prev->second.size;
+            eraseFree(prev_offset, prev->second.size);
+            blocks_.erase(offset);
+            offset = prev_offset;
+        }
+    }
+    blocks_.erase(offset);
+    insertFree(offset, size);
+}
+
+void* DevicePool::acquire(Handle allocation) {
+    uint32_t state = allocation->state.load(std::memory_order_relaxed);
+    for (;;) {
+        if (state & kMovingFlag) {
+            // Compaction is relocating this block; it is released shortly
+            std::this_thread::yield();
+            state = allocation->state.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (allocation->state.compare_exchange_weak(state, state + 1,
+                                                    std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+            return allocation->ptr.load(std::memory_order_acquire);
+        }
+    }
+}
+
+void DevicePool::release(Handle allocation) {
+    allocation->state.fetch_sub(1, std::memory_order_release);
+}
+
+void* DevicePool::address(Handle allocation) const {
+    return allocation->ptr.load(std::memory_order_acquire);
+}
+
+size_t DevicePool::getSize(Handle allocation) const {
+    return allocation->size;
+}
+
+size_t DevicePool::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return compactLocked();
+}
+
+bool DevicePool::safePoint() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (statsLocked().fragmentation <= config_.compaction_threshold) {
+        return false;
+    }
+    compactLocked();
+    return true;
+}
+
+size_t DevicePool::compactLocked() {
+    std::map<size_t, Block> compacted;
+    free_by_size_.clear();
+
+    size_t write = 0;
+    size_t moved = 0;
+    for (auto& entry : blocks_) {
+        size_t offset = entry.first;
+        Block& block = entry.second;
+        if (block.owner == nullptr) {
+            continue;
+        }
+
+        Allocation* allocation = block.owner;
+        uint32_t unpinned = 0;
+        if (write < offset && allocation->movable &&
+            allocation->state.compare_exchange_strong(unpinned, kMovingFlag,
+                                                      std::memory_order_acquire)) {
+            // Sliding down only ever overlaps forwards, memmove semantics suffice
+            config_.ops.move(base_ + write, base_ + offset, block.size);
+            allocation->offset = write;
+            allocation->ptr.store(base_ + write, std::memory_order_release);
+            allocation->state.store(0, std::memory_order_release);
+            compacted[write] = block;
+            moved += block.size;
+            write += block.size;
+        } else {
+            // Pinned or immovable, the gap in front of it stays free
+            if (write < offset) {
+                compacted[write] = Block{offset - write, nullptr};
+                free_by_size_.emplace(offset - write, write);
+            }
+            compacted[offset] = block;
+            write = offset + block.size;
+        }
+    }
+    if (write < config_.capacity) {
+        compacted[write] = Block{config_.capacity - write, nullptr};
+        free_by_size_.emplace(config_.capacity - write, write);
+    }
+
+    blocks_.swap(compacted);
+    compactions_++;
+    bytes_moved_ += moved;
+    return moved;
+}
+
+DevicePool::PoolStats DevicePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statsLocked();
+}
+
+DevicePool::PoolStats DevicePool::statsLocked() const {
+    PoolStats stats{};
+    stats.capacity = config_.capacity;
+    stats.used_bytes = used_bytes_;
+    stats.free_bytes = config_.capacity - used_bytes_;
+    stats.largest_free_block = free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first;
+    stats.free_blocks = free_by_size_.size();
+    stats.fragmentation = stats.free_bytes == 0
+        ? 0.0
+        : 1.0 - static_cast<double>(stats.largest_free_block) / stats.free_bytes;
+    stats.compactions = compactions_;
+    stats.bytes_moved = bytes_moved_;
+    return stats;
+}
+
+} // namespace core
+} // namespace uta
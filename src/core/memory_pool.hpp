@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace uta {
+namespace core {
+
+// Device memory pool with online compaction
+//
+// The pool carves allocations out of one contiguous arena. Movable allocations
+// are reached through a handle; compact() slides every unpinned movable block
+// towards the start of the arena so that free space coalesces into large
+// regions, and republishes the new address through the handle. Immovable
+// allocations and pinned handles stay where they are and act as barriers.
+//
+// Device tensors under a memory limit live in the pool of their MemoryBudget
+// (MemoryBudget::getPool()) and move unless a TensorScope pins them;
+// MemoryManager allocations do not live in a DevicePool.
+class DevicePool {
+public:
+    // Device memory primitives
+    struct PoolOps {
+        std::function<void*(size_t)> allocate;
+        std::function<void(void*, size_t)> free;
+        std::function<void(void*, const void*, size_t)> move;   // memmove semantics
+    };
+
+    struct PoolConfig {
+        size_t capacity;                // arena bytes
+        size_t alignment;               // allocation granularity, power of two
+        double compaction_threshold;    // safePoint() compacts above this fragmentation
+        PoolOps ops;                    // unset members fall back to host memory
+    };
+
+    struct PoolStats {
+        size_t capacity;
+        size_t used_bytes;
+        size_t free_bytes;
+        size_t largest_free_block;
+        size_t free_blocks;
+        double fragmentation;           // 1 - largest_free_block / free_bytes
+        size_t compactions;
+        size_t bytes_moved;
+    };
+
+    class Allocation;
+    using Handle = Allocation*;
+
+    explicit DevicePool(const PoolConfig& config);
+    ~DevicePool();
+
+    DevicePool(const DevicePool&) = delete;
+    DevicePool& operator=(const DevicePool&) = delete;
+
+    // Allocation; with compact set, a request that fails only because free
+    // space is split compacts the pool, so the caller must be at a safe point
+    // as for compact()
+    Handle allocate(size_t size, bool movable = true, bool compact = false);
+    void free(Handle allocation);
+
+    // Pinned access; the address is stable until the matching release()
+    void* acquire(Handle allocation);
+    void release(Handle allocation);
+
+    // Unpinned address, only meaningful between safe points
+    void* address(Handle allocation) const;
+    size_t getSize(Handle allocation) const;
+
+    // Compaction; callers guarantee no device work is using unpinned addresses
+    size_t compact();
+    bool safePoint();
+
+    PoolStats getStats() const;
+
+private:
+    struct Block {
+        size_t size;
+        Allocation* owner;      // nullptr for free blocks
+    };
+
+    void insertFree(size_t offset, size_t size);
+    void eraseFree(size_t offset, size_t size);
+    bool tryAllocate(size_t size, bool movable, Handle& result);
+    size_t compactLocked();
+    PoolStats statsLocked() const;
+
+    PoolConfig config_;
+    uint8_t* base_{nullptr};
+
+    std::map<size_t, Block> blocks_;                // every block by offset
+    std::multimap<size_t, size_t> free_by_size_;    // size -> offset
+    size_t used_bytes_{0};
+    size_t compactions_{0};
+    size_t bytes_moved_{0};
+    mutable std::mutex mutex_;
+};
+
+} // namespace core
+} // namespace uta
@@ -0,0 +1,104 @@
+#include "admission_controller.hpp"
+#include <algorithm>
+
+namespace uta {
+namespace runtime {
+
+void AdmissionController::setLimit(int device_id, size_t bytes) {
+    if (bytes == 0) {
+        devices_.erase(device_id);
+        return;
+    }
+    auto& device = devices_[device_id];
+    if (!device) {
+        device = std::make_unique<DeviceAdmission>();
+    }
+    device->limit = bytes;
+}
+
+AdmissionController::DeviceAdmission* AdmissionController::find(int device_id) const {
+    auto it = devices_.find(device_id);
+    return it == devices_.end() ? nullptr : it->second.get();
+}
+
+bool AdmissionController::fits(const DeviceAdmission& device, size_t bytes) const {
+    // An oversized task still runs once the device is otherwise empty
+    return device.reserved + bytes <= device.limit || device.reserved == 0;
+}
+
+void AdmissionController::reserve(DeviceAdmission& device, size_t bytes) {
+    device.reserved += bytes;
+    device.peak_reserved = std::max(device.peak_reserved, device.reserved);
+    device.admitted++;
+}
+
+bool AdmissionController::admit(int device_id, const Request& request) {
+    DeviceAdmission* device = find(device_id);
+    if (device == nullptr || request.bytes == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(device->mutex);
+    if (device->waiting.empty()) {
+        if (fits(*device, request.bytes)) {
+            reserve(*device, request.bytes);
+            return true;
+        }
+    } else if (device->waiting.front().bypassed < kMaxBypass && fits(*device, request.bytes)) {
+        device->waiting.front().bypassed++;
+        device->backfilled++;
+        reserve(*device, request.bytes);
+        return true;
+    }
+    device->waiting.push_back(Waiting{request, 0});
+    device->deferred++;
+    return false;
+}
+
+void AdmissionController::release(int device_id, size_t bytes, std::vector<Request>& admitted) {
+    DeviceAdmission* device = find(device_id);
+    if (device == nullptr || bytes == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(device->mutex);
+    device->reserved -= std::min(bytes, device->reserved);
+
+    // Admit in arrival order; later requests backfill around one that does not fit
+    auto it = device->waiting.begin();
+    while (it != device->waiting.end()) {
+        bool is_head = it == device->waiting.begin();
+        if (!is_head && device->waiting.front().bypassed >= kMaxBypass) {
+            break;
+        }
+        if (fits(*device, it->request.bytes)) {
+            if (!is_head) {
+                device->waiting.front().bypassed++;
+                device->backfilled++;
+            }
+            reserve(*device, it->request.bytes);
+            admitted.push_back(it->request);
+            it = device->waiting.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+AdmissionController::AdmissionStats AdmissionController::getStats(int device_id) const {
+    AdmissionStats stats{};
+    DeviceAdmission* device = find(device_id);
+    if (device == nullptr) {
+        return stats;
+    }
+    std::lock_guard<std::mutex> lock(device->mutex);
+    stats.memory_limit = device->limit;
+    stats.reserved_bytes = device->reserved;
+    stats.peak_reserved_bytes = device->peak_reserved;
+    stats.waiting_tasks = device->waiting.size();
+    stats.admitted_tasks = device->admitted;
+    stats.deferred_tasks = device->deferred;
+    stats.backfilled_tasks = device->backfilled;
+    return stats;
+}
+
+} // namespace runtime
+} // namespace uta
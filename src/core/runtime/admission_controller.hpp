@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace uta {
+namespace runtime {
+
+class WorkItem;
+
+// Memory admission control for queued tasks
+//
+// A task that declares a device memory requirement reserves it before it is
+// queued. A task that does not fit waits until running tasks release theirs;
+// meanwhile smaller tasks that do fit may backfill past it, but only
+// kMaxBypass times, after which the waiting task holds the line until it is
+// admitted. A task larger than the whole limit runs alone.
+class AdmissionController {
+public:
+    static constexpr size_t kMaxBypass = 8;
+
+    // Queue placement of a waiting task
+    struct Request {
+        WorkItem* item;
+        size_t tier;
+        size_t worker;
+        size_t bytes;
+    };
+
+    struct AdmissionStats {
+        size_t memory_limit;
+        size_t reserved_bytes;
+        size_t peak_reserved_bytes;
+        size_t waiting_tasks;
+        size_t admitted_tasks;
+        size_t deferred_tasks;
+        size_t backfilled_tasks;
+    };
+
+    // 0 removes the limit; not safe while tasks are admitted
+    void setLimit(int device_id, size_t bytes);
+
+    bool enabled() const { return !devices_.empty(); }
+
+    // true if the request was admitted now, otherwise it waits for release()
+    bool admit(int device_id, const Request& request);
+
+    // Return a reservation; waiting requests that now fit are added to admitted
+    void release(int device_id, size_t bytes, std::vector<Request>& admitted);
+
+    AdmissionStats getStats(int device_id) const;
+
+private:
+    struct Waiting {
+        Request request;
+        size_t bypassed;
+    };
+
+    struct DeviceAdmission {
+        size_t limit;
+        size_t reserved{0};
+        size_t peak_reserved{0};
+        size_t admitted{0};
+        size_t deferred{0};
+        size_t backfilled{0};
+        std::deque<Waiting> waiting;
+        std::mutex mutex;
+    };
+
+    // Called with DeviceAdmission::mutex held
+    bool fits(const DeviceAdmission& device, size_t bytes) const;
+    void reserve(DeviceAdmission& device, size_t bytes);
+
+    DeviceAdmission* find(int device_id) const;
+
+    // Only changes while the scheduler is stopped, so lookups need no lock
+    std::unordered_map<int, std::unique_ptr<DeviceAdmission>> devices_;
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,284 @@
+#include "copy_engine.hpp"
+#include "scheduler.hpp"
+#include "topology.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTA_STREAMING_STORES_X86 1
+#endif
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+constexpr size_t kCopyTier = static_cast<size_t>(TaskPriority::NORMAL);
+
+// Below this a single memcpy beats waking extra threads
+constexpr size_t kDefaultParallelThreshold = 8 << 20;
+constexpr size_t kDefaultChunkSize = 4 << 20;
+constexpr size_t kFallbackCacheSize = 32 << 20;
+
+size_t lastLevelCacheSize() {
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size > 0) {
+        return static_cast<size_t>(size);
+    }
+#endif
+    return kFallbackCacheSize;
+}
+
+} // namespace
+
+struct CopyEngine::Job {
+    uint8_t* dst;
+    const uint8_t* src;
+    size_t size;
+    size_t chunk_size;
+    size_t num_chunks;
+    bool streaming;
+    std::function<void()> on_complete;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::unique_ptr<ChunkItem[]> items;
+    std::atomic<size_t> chunks_left;
+    std::atomic<size_t> references;     // dispatched items plus a waiting caller
+
+    // Copies the chunk unless another thread already took it
+    void copyChunk(size_t index) {
+        if (claimed[index].exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        size_t begin = index * chunk_size;
+        size_t length = std::min(chunk_size, size - begin);
+        if (streaming) {
+            streamCopy(dst + begin, src + begin, length);
+        } else {
+            std::memcpy(dst + begin, src + begin, length);
+        }
+        if (chunks_left.fetch_sub(1, std::memory_order_acq_rel) == 1 && on_complete) {
+            on_complete();
+        }
+    }
+
+    void release() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+};
+
+class CopyEngine::ChunkItem : public WorkItem {
+public:
+    void run(ExecutionContext&) override {
+        Job* owner = job;
+        owner->copyChunk(index);
+        // May free this item
+        owner->release();
+    }
+
+    Job* job{nullptr};
+    size_t index{0};
+};
+
+CopyEngine& CopyEngine::getInstance() {
+    static CopyEngine instance;
+    return instance;
+}
+
+CopyEngine::CopyEngine()
+    : parallel_threshold_(kDefaultParallelThreshold)
+    , chunk_size_(kDefaultChunkSize)
+    , streaming_threshold_(lastLevelCacheSize())
+{}
+
+CopyEngine::CopyConfig CopyEngine::getConfig() const {
+    return CopyConfig{
+        parallel_threshold_.load(std::memory_order_relaxed),
+        chunk_size_.load(std::memory_order_relaxed),
+        streaming_threshold_.load(std::memory_order_relaxed)
+    };
+}
+
+void CopyEngine::setConfig(const CopyConfig& config) {
+    if (config.chunk_size == 0 || config.chunk_size % kCacheLine != 0) {
+        throw std::invalid_argument("Copy chunk size must be a positive multiple of 64");
+    }
+    parallel_threshold_.store(config.parallel_threshold, std::memory_order_relaxed);
+    chunk_size_.store(config.chunk_size, std::memory_order_relaxed);
+    streaming_threshold_.store(config.streaming_threshold, std::memory_order_relaxed);
+}
+
+void CopyEngine::copy(void* dst, const void* src, size_t size) {
+    Job* job = createJob(dst, src, size);
+    if (job == nullptr) {
+        return;
+    }
+
+    Scheduler& scheduler = Scheduler::getInstance();
+    if (scheduler.getNumWorkers() == 0) {
+        copyWithThreads(*job);
+        delete job;
+        return;
+    }
+
+    job->references.store(job->num_chunks + 1, std::memory_order_relaxed);
+    dispatchChunks(*job);
+    for (size_t i = 0; i < job->num_chunks; ++i) {
+        job->copyChunk(i);
+    }
+    while (job->chunks_left.load(std::memory_order_acquire) != 0) {
+        if (!scheduler.runPendingWork()) {
+            std::this_thread::yield();
+        }
+    }
+    job->release();
+}
+
+void CopyEngine::copyAsync(void* dst, const void* src, size_t size,
+                           std::function<void()> on_complete) {
+    Job* job = nullptr;
+    if (Scheduler::getInstance().getNumWorkers() == 0) {
+        copy(dst, src, size);
+    } else {
+        job = createJob(dst, src, size);
+    }
+    if (job == nullptr) {
+        if (on_complete) {
+            on_complete();
+        }
+        return;
+    }
+    job->on_complete = std::move(on_complete);
+    job->references.store(job->num_chunks, std::memory_order_relaxed);
+    dispatchChunks(*job);
+}
+
+CopyEngine::CopyStats CopyEngine::getStats() const {
+    return CopyStats{
+        copies_.load(std::memory_order_relaxed),
+        parallel_copies_.load(std::memory_order_relaxed),
+        bytes_copied_.load(std::memory_order_relaxed),
+        bytes_streamed_.load(std::memory_order_relaxed)
+    };
+}
+
+CopyEngine::Job* CopyEngine::createJob(void* dst, const void* src, size_t size) {
+    bool streaming = size > streaming_threshold_.load(std::memory_order_relaxed);
+    copies_.fetch_add(1, std::memory_order_relaxed);
+    bytes_copied_.fetch_add(size, std::memory_order_relaxed);
+    if (streaming) {
+        bytes_streamed_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    size_t chunk_size = chunk_size_.load(std::memory_order_relaxed);
+    if (size < parallel_threshold_.load(std::memory_order_relaxed) || size <= chunk_size) {
+        if (streaming) {
+            streamCopy(dst, src, size);
+        } else {
+            std::memcpy(dst, src, size);
+        }
+        return nullptr;
+    }
+    parallel_copies_.fetch_add(1, std::memory_order_relaxed);
+
+    Job* job = new Job();
+    job->dst = static_cast<uint8_t*>(dst);
+    job->src = static_cast<const uint8_t*>(src);
+    job->size = size;
+    job->chunk_size = chunk_size;
+    job->num_chunks = (size + chunk_size - 1) / chunk_size;
+    job->streaming = streaming;
+    job->claimed.reset(new std::atomic<bool>[job->num_chunks]);
+    job->items.reset(new ChunkItem[job->num_chunks]);
+    for (size_t i = 0; i < job->num_chunks; ++i) {
+        job->claimed[i].store(false, std::memory_order_relaxed);
+        job->items[i].job = job;
+        job->items[i].index = i;
+    }
+    job->chunks_left.store(job->num_chunks, std::memory_order_relaxed);
+    return job;
+}
+
+void CopyEngine::dispatchChunks(Job& job) {
+    Scheduler& scheduler = Scheduler::getInstance();
+    bool numa = !scheduler.node_workers_.empty();
+    size_t num_chunks = job.num_chunks;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        // Writes are the expensive side of a copy; run them near the destination
+        size_t worker = numa
+            ? scheduler.selectWorker(CpuTopology::nodeOfAddress(job.dst + i * job.chunk_size))
+            : Scheduler::kNotAWorker;
+        bool dispatched = worker == Scheduler::kNotAWorker
+            ? scheduler.tryDispatch(&job.items[i], kCopyTier)
+            : scheduler.tryDispatch(&job.items[i], kCopyTier, worker);
+        if (!dispatched) {
+            // The scheduler shut down; copy the chunk here. Later items still
+            // hold their references, so the job outlives all but the last one
+            ExecutionContext context;
+            job.items[i].run(context);
+        }
+    }
+}
+
+void CopyEngine::copyWithThreads(Job& job) {
+    size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                          job.num_chunks);
+    auto copy_stride = [&job, num_threads](size_t first) {
+        for (size_t i = first; i < job.num_chunks; i += num_threads) {
+            job.copyChunk(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(copy_stride, t);
+    }
+    copy_stride(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void CopyEngine::streamCopy(void* dst, const void* src, size_t size) {
+#if defined(UTA_STREAMING_STORES_X86)
+    auto* out = static_cast<uint8_t*>(dst);
+    auto* in = static_cast<const uint8_t*>(src);
+
+    // Streaming stores need 16-byte aligned destinations
+    size_t head = std::min(size, (16 - reinterpret_cast<uintptr_t>(out) % 16) % 16);
+    std::memcpy(out, in, head);
+    out += head;
+    in += head;
+    size -= head;
+
+    for (; size >= kCacheLine; size -= kCacheLine, out += kCacheLine, in += kCacheLine) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out + 48), d);
+    }
+    // Order the weakly-ordered stores before whatever publishes completion
+    _mm_sfence();
+    std::memcpy(out, in, size);
+#else
+    std::memcpy(dst, src, size);
+#endif
+}
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace uta {
+namespace runtime {
+
+// Chunked host memory copies on the scheduler's workers
+//
+// A large copy is split into cache-line aligned chunks, one work item each.
+// On multi-node machines each chunk goes to a worker pinned to the NUMA node
+// holding its destination pages, so the writes stay node-local. Copies too
+// large to fit in the last-level cache use non-temporal stores, which skip
+// the read-for-ownership of destination lines and leave the cache to the
+// rest of the program. Without scheduler workers, copy() falls back to
+// short-lived threads and copyAsync() copies inline.
+class CopyEngine {
+public:
+    struct CopyConfig {
+        size_t parallel_threshold;      // below this, one memcpy on the caller
+        size_t chunk_size;              // bytes per work item, multiple of 64
+        size_t streaming_threshold;     // copies above this bypass the cache
+    };
+
+    struct CopyStats {
+        size_t copies;
+        size_t parallel_copies;
+        size_t bytes_copied;
+        size_t bytes_streamed;
+    };
+
+    static CopyEngine& getInstance();
+
+    CopyConfig getConfig() const;
+    void setConfig(const CopyConfig& config);
+
+    // Returns once the copy is done; the caller copies chunks too
+    void copy(void* dst, const void* src, size_t size);
+
+    // Returns at once; on_complete runs on whichever thread finishes the
+    // last chunk. Both buffers must stay valid until then.
+    void copyAsync(void* dst, const void* src, size_t size, std::function<void()> on_complete);
+
+    CopyStats getStats() const;
+
+    // memcpy through non-temporal stores where the CPU has them
+    static void streamCopy(void* dst, const void* src, size_t size);
+
+private:
+    struct Job;
+    class ChunkItem;
+
+    CopyEngine();
+
+    CopyEngine(const CopyEngine&) = delete;
+    CopyEngine& operator=(const CopyEngine&) = delete;
+
+    // nullptr when the copy is small enough to do on the caller
+    Job* createJob(void* dst, const void* src, size_t size);
+    void dispatchChunks(Job& job);
+    void copyWithThreads(Job& job);
+
+    std::atomic<size_t> parallel_threshold_;
+    std::atomic<size_t> chunk_size_;
+    std::atomic<size_t> streaming_threshold_;
+
+    std::atomic<size_t> copies_{0};
+    std::atomic<size_t> parallel_copies_{0};
+    std::atomic<size_t> bytes_copied_{0};
+    std::atomic<size_t> bytes_streamed_{0};
+};
+
+} // namespace runtime
+} // namespace uta
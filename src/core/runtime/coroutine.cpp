@@ -0,0 +1,77 @@
+#include "coroutine.hpp"
+#include <algorithm>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+// poll interval backs off while nothing completes
+constexpr std::chrono::microseconds kMinPollInterval(20);
+constexpr std::chrono::microseconds kMaxPollInterval(1000);
+
+} // namespace
+
+FuturePoller& FuturePoller::getInstance() {
+    static FuturePoller instance;
+    return instance;
+}
+
+FuturePoller::~FuturePoller() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void FuturePoller::watch(std::function<bool()> ready, WorkItem* item, size_t tier) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    watches_.push_back(Watch{std::move(ready), item, tier});
+    if (!thread_.joinable()) {
+        thread_ = std::thread([this] { pollLoop(); });
+    }
+    condition_.notify_one();
+}
+
+void FuturePoller::pollLoop() {
+    std::vector<Watch> polling;
+    auto interval = kMinPollInterval;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (watches_.empty() && polling.empty()) {
+            condition_.wait(lock, [this] { return stopping_ || !watches_.empty(); });
+            interval = kMinPollInterval;
+            continue;
+        }
+        std::move(watches_.begin(), watches_.end(), std::back_inserter(polling));
+        watches_.clear();
+        lock.unlock();
+
+        size_t before = polling.size();
+        auto ready = std::partition(polling.begin(), polling.end(),
+                                    [](const Watch& watch) { return !watch.ready(); });
+        for (auto it = ready; it != polling.end(); ++it) {
+            // After shutdown the waiter resumes on this thread; its frame would leak otherwise
+            if (!Scheduler::getInstance().tryDispatch(it->item, it->tier)) {
+                ExecutionContext context;
+                it->item->run(context);
+            }
+        }
+        polling.erase(ready, polling.end());
+        interval = polling.size() < before
+            ? kMinPollInterval
+            : std::min(interval * 2, kMaxPollInterval);
+
+        lock.lock();
+        if (!polling.empty()) {
+            condition_.wait_for(lock, interval, [this] { return stopping_ || !watches_.empty(); });
+        }
+    }
+}
+
+} // namespace runtime
+} // namespace uta
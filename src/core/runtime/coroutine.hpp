@@ -0,0 +1,357 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// Dispatches a work item once a readiness check passes. Used for waits that
+// offer no completion callback (std::future); one thread polls all of them,
+// so no worker blocks.
+class FuturePoller {
+public:
+    static FuturePoller& getInstance();
+
+    ~FuturePoller();
+
+    void watch(std::function<bool()> ready, WorkItem* item, size_t tier);
+
+private:
+    FuturePoller() = default;
+
+    void pollLoop();
+
+    struct Watch {
+        std::function<bool()> ready;
+        WorkItem* item;
+        size_t tier;
+    };
+
+    std::vector<Watch> watches_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread thread_;
+    bool stopping_{false};
+};
+
+} // namespace runtime
+} // namespace uta
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <uta/uta.hpp>
+
+#define UTA_HAS_COROUTINES 1
+
+namespace uta {
+namespace runtime {
+
+// queue tier resumed coroutines run in
+constexpr size_t kCoroutineTier = static_cast<size_t>(TaskPriority::NORMAL);
+
+template<typename T = void>
+class CoroutineTask;
+
+namespace detail {
+
+// Resumes a suspended coroutine on a scheduler worker. Awaiters embed one, so
+// it lives in the suspended coroutine frame and needs no allocation.
+class ResumeItem : public WorkItem {
+public:
+    void run(ExecutionContext&) override {
+        // resume() may destroy the frame holding this item
+        handle_.resume();
+    }
+
+    // false once the scheduler has shut down; the caller then carries on
+    // inline, so a suspended frame is never left behind
+    bool resumeOnWorker(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        return Scheduler::getInstance().tryDispatch(this, kCoroutineTier);
+    }
+
+    // For completion callbacks on foreign threads
+    void resumeOnWorkerOrHere() {
+        if (!Scheduler::getInstance().tryDispatch(this, kCoroutineTier)) {
+            handle_.resume();
+        }
+    }
+
+    std::coroutine_handle<> handle_;
+};
+
+class PromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            // Symmetric transfer back to whoever awaited this task
+            std::coroutine_handle<> continuation = handle.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template<typename T>
+class Promise : public PromiseBase {
+public:
+    CoroutineTask<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+    T result() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template<>
+class Promise<void> : public PromiseBase {
+public:
+    CoroutineTask<void> get_return_object();
+
+    void return_void() {}
+
+    void result() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine
+//
+// Nothing runs until the task is awaited from another coroutine or handed to
+// schedule(). Suspension points (Events, Streams, futures, callbacks) free
+// the worker; the coroutine resumes on whichever worker is free next.
+template<typename T>
+class CoroutineTask {
+public:
+    using promise_type = detail::Promise<T>;
+
+    explicit CoroutineTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    CoroutineTask(CoroutineTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    CoroutineTask& operator=(CoroutineTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    CoroutineTask(const CoroutineTask&) = delete;
+    CoroutineTask& operator=(const CoroutineTask&) = delete;
+
+    ~CoroutineTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template<typename T>
+CoroutineTask<T> Promise<T>::get_return_object() {
+    return CoroutineTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline CoroutineTask<void> Promise<void>::get_return_object() {
+    return CoroutineTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Fire-and-forget frame driving a scheduled task
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Awaiter that suspends and hands a resume item to a completion source
+template<typename Register>
+class CallbackAwaiter {
+public:
+    explicit CallbackAwaiter(Register on_suspend) : on_suspend_(std::move(on_suspend)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        item_.handle_ = handle;
+        ResumeItem* item = &item_;
+        on_suspend_([item] { item->resumeOnWorkerOrHere(); });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    Register on_suspend_;
+    ResumeItem item_;
+};
+
+// Awaits anything with query() and addCallback(), i.e. Event and Stream
+template<typename Source>
+struct CompletionAwaiter {
+    bool await_ready() { return source_.query(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        item_.handle_ = handle;
+        ResumeItem* item = &item_;
+        source_.addCallback([item] { item->resumeOnWorkerOrHere(); });
+    }
+
+    void await_resume() const noexcept {}
+
+    Source& source_;
+    ResumeItem item_;
+};
+
+} // namespace detail
+
+// co_await resumeOnWorker(): continue on a scheduler worker
+inline auto resumeOnWorker() {
+    struct Awaiter {
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { return item_.resumeOnWorker(handle); }
+        void await_resume() const noexcept {}
+        detail::ResumeItem item_;
+    };
+    return Awaiter{};
+}
+
+// co_await awaitCallback(start): start(done) begins an operation that calls
+// done() on completion, e.g. a collective or a device callback
+template<typename Start>
+auto awaitCallback(Start start) {
+    auto on_suspend = [start = std::move(start)](std::function<void()> done) mutable {
+        start(std::move(done));
+    };
+    return detail::CallbackAwaiter<decltype(on_suspend)>(std::move(on_suspend));
+}
+
+// co_await awaitFuture(scheduler.submitTask(...))
+template<typename T>
+auto awaitFuture(std::future<T> future) {
+    struct Awaiter {
+        bool await_ready() const {
+            return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            item_.handle_ = handle;
+            std::future<T>* future = &future_;
+            FuturePoller::getInstance().watch(
+                [future] {
+                    return future->wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                },
+                &item_, kCoroutineTier);
+        }
+
+        T await_resume() { return future_.get(); }
+
+        std::future<T> future_;
+        detail::ResumeItem item_;
+    };
+    return Awaiter{std::move(future), {}};
+}
+
+namespace detail {
+
+template<typename T>
+Detached drive(CoroutineTask<T> task, std::promise<T> promise) {
+    co_await resumeOnWorker();
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            promise.set_value();
+        } else {
+            promise.set_value(co_await task);
+        }
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+// Start a task on the scheduler workers
+template<typename T>
+std::future<T> schedule(CoroutineTask<T> task) {
+    if (Scheduler::getInstance().getNumWorkers() == 0) {
+        throw std::runtime_error("Scheduler is not running");
+    }
+    std::promise<T> promise;
+    std::future<T> future = promise.get_future();
+    detail::drive(std::move(task), std::move(promise));
+    return future;
+}
+
+} // namespace runtime
+
+// co_await event / co_await stream inside a uta::task
+inline auto operator co_await(Event& event) {
+    return runtime::detail::CompletionAwaiter<Event>{event, {}};
+}
+
+inline auto operator co_await(Stream& stream) {
+    return runtime::detail::CompletionAwaiter<Stream>{stream, {}};
+}
+
+template<typename T = void>
+using task = runtime::CoroutineTask<T>;
+
+} // namespace uta
+
+#endif
@@ -0,0 +1,163 @@
+#include "critical_path_scheduler.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+// Device a task's output lives on, -1 if unknown
+int outputDevice(const Task& task) {
+    if (auto compute = dynamic_cast<const ComputeTask*>(&task)) {
+        return compute->getDeviceId();
+    }
+    if (auto transfer = dynamic_cast<const MemoryTransferTask*>(&task)) {
+        return transfer->getTargetDevice();
+    }
+    return -1;
+}
+
+// Device a task reads its inputs on, -1 if unknown
+int inputDevice(const Task& task) {
+    if (auto compute = dynamic_cast<const ComputeTask*>(&task)) {
+        return compute->getDeviceId();
+    }
+    if (auto transfer = dynamic_cast<const MemoryTransferTask*>(&task)) {
+        return transfer->getSourceDevice();
+    }
+    return -1;
+}
+
+} // namespace
+
+CriticalPathScheduler::CriticalPathScheduler(const CriticalPathConfig& config)
+    : config_(config)
+{
+    if (config_.num_tiers == 0) {
+        throw std::invalid_argument("CriticalPathScheduler needs at least one tier");
+    }
+}
+
+double CriticalPathScheduler::costLocked(const Task& task) const {
+    auto it = average_cost_.find(task.getName());
+    if (it != average_cost_.end()) {
+        return it->second;
+    }
+    double measured = task.getExecutionTime().count();
+    if (measured > 0.0) {
+        return measured;
+    }
+    if (auto transfer = dynamic_cast<const MemoryTransferTask*>(&task)) {
+        return config_.cross_device_latency +
+               static_cast<double>(transfer->getDataSize()) / config_.transfer_bandwidth;
+    }
+    return config_.default_cost;
+}
+
+double CriticalPathScheduler::edgeCost(const Task& from, const Task& to) const {
+    int source = outputDevice(from);
+    int target = inputDevice(to);
+    return source >= 0 && target >= 0 && source != target ? config_.cross_device_latency : 0.0;
+}
+
+double CriticalPathScheduler::estimateCost(const Task& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return costLocked(task);
+}
+
+void CriticalPathScheduler::prepareGraph(const GraphTopology& graph) {
+    size_t count = graph.tasks.size();
+
+    // Reverse topological order: Kahn's algorithm, then walk it backwards
+    std::vector<size_t> pending(count, 0);
+    for (size_t successor : graph.successors) {
+        pending[successor]++;
+    }
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (pending[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t position = 0; position < order.size(); ++position) {
+        size_t index = order[position];
+        for (size_t e = graph.successor_offsets[index]; e < graph.successor_offsets[index + 1]; ++e) {
+            if (--pending[graph.successors[e]] == 0) {
+                order.push_back(graph.successors[e]);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<double> rank(count, 0.0);
+    max_rank_ = 0.0;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        size_t index = *it;
+        const Task& task = *graph.tasks[index];
+        double longest = 0.0;
+        for (size_t e = graph.successor_offsets[index]; e < graph.successor_offsets[index + 1]; ++e) {
+            size_t successor = graph.successors[e];
+            longest = std::max(longest,
+                               edgeCost(task, *graph.tasks[successor]) + rank[successor]);
+        }
+        rank[index] = costLocked(task) + longest;
+        max_rank_ = std::max(max_rank_, rank[index]);
+    }
+
+    // Ranks are only read while the graph's tiers are frozen, keep the latest graph
+    ranks_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        ranks_[graph.tasks[i].get()] = rank[i];
+    }
+}
+
+void CriticalPathScheduler::releaseGraph(const GraphTopology& graph) {
+    // A later task at a freed node's address must not inherit its rank
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& task : graph.tasks) {
+        ranks_.erase(task.get());
+    }
+    if (ranks_.empty()) {
+        max_rank_ = 0.0;
+    }
+}
+
+double CriticalPathScheduler::getRank(const Task& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ranks_.find(&task);
+    return it == ranks_.end() ? -1.0 : it->second;
+}
+
+size_t CriticalPathScheduler::selectTier(const Task& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ranks_.find(&task);
+    if (it == ranks_.end() || max_rank_ <= 0.0) {
+        // Spread the four priorities over the available tiers
+        size_t priority = static_cast<size_t>(task.getPriority());
+        return priority * config_.num_tiers / kNumPriorityTiers;
+    }
+    // Highest rank -> tier 0
+    double fraction = 1.0 - it->second / max_rank_;
+    size_t tier = static_cast<size_t>(fraction * config_.num_tiers);
+    return std::min(tier, config_.num_tiers - 1);
+}
+
+void CriticalPathScheduler::onTaskComplete(std::shared_ptr<Task> task) {
+    double seconds = task->getExecutionTime().count();
+    if (seconds <= 0.0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = average_cost_.find(task->getName());
+    if (it == average_cost_.end()) {
+        average_cost_.emplace(task->getName(), seconds);
+    } else {
+        it->second += config_.smoothing * (seconds - it->second);
+    }
+}
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// critical path scheduling policy (HEFT upward rank)
+//
+// For every captured graph, a node's upward rank is its estimated cost plus
+// the most expensive path from it to an exit node. Nodes on long paths get
+// the most urgent tiers, so long chains start early and overlap with the
+// short ones. Costs are learned per task name from measured execution
+// times; transfers without measurements are estimated from their size, and
+// edges between tasks on different devices add a transfer latency.
+// Tasks outside a graph keep their TaskPriority tier.
+class CriticalPathScheduler : public SchedulingPolicy {
+public:
+    struct CriticalPathConfig {
+        size_t num_tiers = 8;
+        double default_cost = 1e-4;             // seconds, for never measured tasks
+        double transfer_bandwidth = 10e9;       // bytes/s, unmeasured MemoryTransferTasks
+        double cross_device_latency = 1e-5;     // seconds per edge between devices
+        double smoothing = 0.2;                 // weight of a new execution time sample
+    };
+
+    CriticalPathScheduler() : CriticalPathScheduler(CriticalPathConfig()) {}
+    explicit CriticalPathScheduler(const CriticalPathConfig& config);
+
+    size_t numTiers() const override { return config_.num_tiers; }
+    size_t selectTier(const Task& task) override;
+    void onTaskComplete(std::shared_ptr<Task> task) override;
+    void prepareGraph(const GraphTopology& graph) override;
+    void releaseGraph(const GraphTopology& graph) override;
+
+    // Estimated execution time in seconds
+    double estimateCost(const Task& task);
+
+    // Upward rank from the last prepared graph, negative if the task is not in it
+    double getRank(const Task& task);
+
+private:
+    double costLocked(const Task& task) const;
+    double edgeCost(const Task& from, const Task& to) const;
+
+    CriticalPathConfig config_;
+    std::unordered_map<std::string, double> average_cost_;
+    std::unordered_map<const Task*, double> ranks_;
+    double max_rank_{0.0};
+    std::mutex mutex_;
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,40 @@
+#include "deadline_scheduler.hpp"
+#include "task.hpp"
+
+namespace uta {
+namespace runtime {
+
+size_t DeadlineScheduler::selectTier(const Task& task) {
+    return static_cast<size_t>(task.getPriority());
+}
+
+void DeadlineScheduler::onTaskComplete(std::shared_ptr<Task>) {
+}
+
+bool DeadlineScheduler::enqueue(WorkItem* item) {
+    Task* task = item->getTask();
+    if (task == nullptr || !task->hasDeadline()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push(Entry{task->getDeadline(), next_sequence_++, item});
+    size_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+WorkItem* DeadlineScheduler::dequeue(std::chrono::steady_clock::time_point before) {
+    if (size_.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty() || !(queue_.top().deadline < before)) {
+        return nullptr;
+    }
+    WorkItem* item = queue_.top().item;
+    queue_.pop();
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return item;
+}
+
+} // namespace runtime
+} // namespace uta
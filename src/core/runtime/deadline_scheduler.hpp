@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// earliest deadline first scheduling policy
+//
+// Tasks with a deadline (Task::setDeadline) bypass the tier queues and wait
+// in one queue ordered by deadline; every worker takes the earliest one
+// before any other work. Tasks without a deadline keep their TaskPriority
+// tier and run when no deadline work is queued. Long tasks can call
+// Scheduler::preemptionPoint() between sub-tasks to let more urgent work
+// run first.
+class DeadlineScheduler : public SchedulingPolicy {
+public:
+    size_t selectTier(const Task& task) override;
+    void onTaskComplete(std::shared_ptr<Task> task) override;
+
+    bool ordersWork() const override { return true; }
+    bool enqueue(WorkItem* item) override;
+    bool hasWork() const override { return size_.load(std::memory_order_acquire) > 0; }
+    WorkItem* dequeue(std::chrono::steady_clock::time_point before) override;
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t sequence;      // FIFO among equal deadlines
+        WorkItem* item;
+
+        bool operator>(const Entry& other) const {
+            return deadline != other.deadline ? deadline > other.deadline
+                                              : sequence > other.sequence;
+        }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue_;
+    uint64_t next_sequence_{0};
+    std::atomic<size_t> size_{0};
+    std::mutex mutex_;
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,269 @@
+#include "event.hpp"
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+// Idle dispatcher polling interval bounds
+constexpr auto kMinPollInterval = std::chrono::microseconds(100);
+constexpr auto kMaxPollInterval = std::chrono::milliseconds(10);
+
+uint32_t typeBit(EventType type) {
+    return 1u << static_cast<uint32_t>(type);
+}
+
+bool earlier(const EventRecord& a, const EventRecord& b) {
+    return a.timestamp_ns < b.timestamp_ns;
+}
+
+} // namespace
+
+EventManager& EventManager::getInstance() {
+    static EventManager instance;
+    return instance;
+}
+
+EventManager::~EventManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    if (dispatcher_.joinable()) {
+        dispatcher_.join();
+    }
+}
+
+void EventManager::registerListener(EventType type, std::shared_ptr<EventListener> listener) {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    auto listeners = std::make_shared<ListenerMap>(*listeners_);
+    (*listeners)[type].push_back(listener);
+    listeners_ = std::move(listeners);
+    startDispatcher();
+}
+
+void EventManager::unregisterListener(EventType type, std::shared_ptr<EventListener> listener) {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    auto listeners = std::make_shared<ListenerMap>(*listeners_);
+    auto& entries = (*listeners)[type];
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&listener](const std::weak_ptr<EventListener>& entry) {
+                                     auto current = entry.lock();
+                                     return !current || current == listener;
+                                 }),
+                  entries.end());
+    listeners_ = std::move(listeners);
+}
+
+void EventManager::dispatchEvent(const Event& event) {
+    if (static_cast<int>(event.getPriority()) > min_priority_.load(std::memory_order_relaxed) ||
+        (filtered_types_.load(std::memory_order_relaxed) & typeBit(event.getType())) != 0) {
+        return;
+    }
+    startDispatcher();
+    if (!localRing().push(event.toRecord())) {
+        // Never block the producer; the dispatcher is behind
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EventManager::flush() {
+    startDispatcher();
+    std::vector<std::pair<std::shared_ptr<EventRing>, size_t>> targets;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            targets.emplace_back(ring, ring->pushed());
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    flush_waiters_++;
+    condition_.notify_all();
+    flushed_condition_.wait(lock, [&targets] {
+        for (const auto& target : targets) {
+            if (target.first->delivered.load(std::memory_order_acquire) < target.second) {
+                return false;
+            }
+        }
+        return true;
+    });
+    flush_waiters_--;
+}
+
+void EventManager::setPriorityFilter(EventPriority min_priority) {
+    min_priority_.store(static_cast<int>(min_priority), std::memory_order_relaxed);
+}
+
+void EventManager::addTypeFilter(EventType type) {
+    filtered_types_.fetch_or(typeBit(type), std::memory_order_relaxed);
+}
+
+void EventManager::removeTypeFilter(EventType type) {
+    filtered_types_.fetch_and(~typeBit(type), std::memory_order_relaxed);
+}
+
+std::vector<EventRecord> EventManager::getEventHistory(
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end)
+{
+    EventRecord first{};
+    EventRecord last{};
+    first.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        start.time_since_epoch()).count();
+    last.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        end.time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    auto begin = std::lower_bound(event_history_.begin(), event_history_.end(), first, earlier);
+    auto stop = std::upper_bound(begin, event_history_.end(), last, earlier);
+    return std::vector<EventRecord>(begin, stop);
+}
+
+void EventManager::setHistoryCapacity(size_t records) {
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    history_capacity_ = records;
+    while (event_history_.size() > history_capacity_) {
+        event_history_.pop_front();
+    }
+}
+
+EventManager::EventStats EventManager::getStats() const {
+    EventStats stats{};
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        stats.producers = rings_.size();
+    }
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    stats.history_size = event_history_.size();
+    return stats;
+}
+
+EventRing& EventManager::localRing() {
+    // Retires the thread's ring when the thread exits
+    struct RingHandle {
+        ~RingHandle() {
+            if (ring) {
+                ring->retired.store(true, std::memory_order_release);
+            }
+        }
+        std::shared_ptr<EventRing> ring;
+    };
+    thread_local RingHandle handle;
+
+    if (!handle.ring) {
+        handle.ring = std::make_shared<EventRing>();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(handle.ring);
+    }
+    return *handle.ring;
+}
+
+void EventManager::startDispatcher() {
+    std::call_once(dispatcher_started_, [this] {
+        dispatcher_ = std::thread([this] { dispatchLoop(); });
+    });
+}
+
+void EventManager::dispatchLoop() {
+    auto interval = kMinPollInterval;
+    for (;;) {
+        bool found = drain();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (flush_waiters_ > 0) {
+            flushed_condition_.notify_all();
+        }
+        if (found) {
+            interval = kMinPollInterval;
+            continue;
+        }
+        if (stopping_) {
+            break;
+        }
+        // Producers never signal; poll less often while the bus stays idle
+        condition_.wait_for(lock, interval);
+        interval = std::min<std::chrono::microseconds>(interval * 2, kMaxPollInterval);
+    }
+}
+
+bool EventManager::drain() {
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        dispatcher_rings_ = rings_;
+    }
+    std::shared_ptr<const ListenerMap> listeners;
+    {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        listeners = listeners_;
+    }
+
+    batch_.clear();
+    EventRecord record;
+    for (const auto& ring : dispatcher_rings_) {
+        for (size_t i = 0; i < EventRing::kCapacity && ring->pop(record); ++i) {
+            batch_.push_back(record);
+        }
+    }
+
+    if (!batch_.empty()) {
+        // Rings are each in order; merge them by time
+        std::stable_sort(batch_.begin(), batch_.end(), earlier);
+        {
+            std::lock_guard<std::mutex> lock(history_mutex_);
+            for (const EventRecord& entry : batch_) {
+                addToHistory(entry);
+            }
+        }
+        for (const EventRecord& entry : batch_) {
+            auto it = listeners->find(entry.type);
+            if (it == listeners->end()) {
+                continue;
+            }
+            for (const auto& weak : it->second) {
+                if (auto listener = weak.lock()) {
+                    try {
+                        listener->onEvent(entry);
+                    } catch (...) {
+                        // A failing listener must not stop delivery to the others
+                    }
+                }
+            }
+        }
+        delivered_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    }
+
+    for (const auto& ring : dispatcher_rings_) {
+        ring->delivered.store(ring->popped(), std::memory_order_release);
+    }
+
+    // Drop rings of exited threads once they are empty
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<EventRing>& ring) {
+                                        return ring->retired.load(std::memory_order_acquire) &&
+                                               ring->empty();
+                                    }),
+                     rings_.end());
+    }
+    dispatcher_rings_.clear();
+    return !batch_.empty();
+}
+
+// Called with history_mutex_ held
+void EventManager::addToHistory(const EventRecord& record) {
+    // Records arrive nearly in order, so the insertion point is close to the end
+    auto position = event_history_.end();
+    while (position != event_history_.begin() && earlier(record, *(position - 1))) {
+        --position;
+    }
+    event_history_.insert(position, record);
+    while (event_history_.size() > history_capacity_) {
+        event_history_.pop_front();
+    }
+}
+
+} // namespace runtime
+} // namespace uta
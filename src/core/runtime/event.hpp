@@ -1,9 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <memory>
 #include <string>
 #include <functional>
 #include <chrono>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
@@ -34,6 +41,38 @@ enum class EventPriority {
     LOW
 };
 
+// Fixed-size event record kept in the event bus and its history
+struct EventRecord {
+    int64_t timestamp_ns;       // steady_clock time since epoch
+    uint64_t value;             // event specific, e.g. a size in bytes
+    EventType type;
+    EventPriority priority;
+    int32_t device_id;          // -1 if none
+    char text[36];              // NUL-terminated, truncated description
+
+    std::chrono::steady_clock::time_point getTimestamp() const {
+        return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timestamp_ns));
+    }
+
+    std::string getText() const { return std::string(text); }
+
+    void setText(const std::string& description) {
+        size_t length = std::min(description.size(), sizeof(text) - 1);
+        std::memcpy(text, description.data(), length);
+        text[length] = '\0';
+    }
+
+    void appendText(const std::string& description) {
+        size_t used = std::strlen(text);
+        size_t length = std::min(description.size(), sizeof(text) - 1 - used);
+        std::memcpy(text + used, description.data(), length);
+        text[used + length] = '\0';
+    }
+};
+
+static_assert(std::is_trivially_copyable<EventRecord>::value, "EventRecord must be POD");
+static_assert(sizeof(EventRecord) == 64, "EventRecord should fill one cache line");
+
 // event base class
 class Event {
 public:
@@ -51,7 +90,23 @@ public:
 
     virtual std::string toString() const = 0;
 
+    EventRecord toRecord() const {
+        EventRecord record{};
+        record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            timestamp_.time_since_epoch()).count();
+        record.type = type_;
+        record.priority = priority_;
+        record.device_id = -1;
+        describe(record);
+        return record;
+    }
+
 protected:
+    // Fill the event specific fields of a record
+    virtual void describe(EventRecord& record) const {
+        record.setText(toString());
+    }
+
     EventType type_;
     EventPriority priority_;
     std::chrono::steady_clock::time_point timestamp_;
@@ -74,6 +129,14 @@ public:
         return "TaskEvent: " + task_name_ + " (" + task_id_ + ")";
     }
 
+protected:
+    void describe(EventRecord& record) const override {
+        record.setText(task_name_);
+        record.appendText(" (");
+        record.appendText(task_id_);
+        record.appendText(")");
+    }
+
 private:
     std::string task_name_;
     std::string task_id_;
@@ -97,6 +160,12 @@ public:
                std::to_string(device_id_);
     }
 
+protected:
+    void describe(EventRecord& record) const override {
+        record.value = size_;
+        record.device_id = device_id_;
+    }
+
 private:
     size_t size_;
     int device_id_;
@@ -119,23 +188,85 @@ public:
         return "ErrorEvent: " + error_message_;
     }
 
+protected:
+    void describe(EventRecord& record) const override {
+        record.setText(error_message_);
+    }
+
 private:
     std::string error_message_;
     std::string stack_trace_;
 };
 
-// Event Listener Interface
+// Event Listener Interface; called on the event bus dispatcher thread
 class EventListener {
 public:
     virtual ~EventListener() = default;
-    virtual void onEvent(const Event& event) = 0;
+    virtual void onEvent(const EventRecord& event) = 0;
+};
+
+// Single-producer single-consumer ring of event records
+class EventRing {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    // Producer side; false when the ring is full
+    bool push(const EventRecord& record) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == kCapacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == kCapacity) {
+                return false;
+            }
+        }
+        records_[tail % kCapacity] = record;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(EventRecord& record) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        record = records_[head % kCapacity];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t pushed() const { return tail_.load(std::memory_order_acquire); }
+    size_t popped() const { return head_.load(std::memory_order_acquire); }
+
+    // set when the producing thread exits
+    std::atomic<bool> retired{false};
+
+    // records the consumer has finished handling
+    std::atomic<size_t> delivered{0};
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_{0};      // producer's view of head_
+    EventRecord records_[kCapacity];
 };
 
 // Event Manager
+//
+// Each producing thread writes records into its own EventRing without
+// locks; a full ring drops the event and counts it. A dispatcher thread
+// drains the rings, keeps the most recent records in a time-ordered history
+// and calls listeners, so dispatchEvent never waits on a listener.
 class EventManager {
 public:
     static EventManager& getInstance();
 
+    ~EventManager();
+
     // Event Registration
     void registerListener(EventType type, std::shared_ptr<EventListener> listener);
     void unregisterListener(EventType type, std::shared_ptr<EventListener> listener);
@@ -143,32 +274,73 @@ public:
     // Event Dispatch
     void dispatchEvent(const Event& event);
 
+    // Wait until events dispatched so far reached the history and listeners
+    void flush();
+
     // Event Filtering
     void setPriorityFilter(EventPriority min_priority);
     void addTypeFilter(EventType type);
     void removeTypeFilter(EventType type);
 
     // Event Query
-    std::vector<std::shared_ptr<Event>> getEventHistory(
+    std::vector<EventRecord> getEventHistory(
         std::chrono::steady_clock::time_point start,
         std::chrono::steady_clock::time_point end
     );
 
+    void setHistoryCapacity(size_t records);
+
+    struct EventStats {
+        size_t delivered;       // records handled by the dispatcher
+        size_t dropped;         // records lost to a full ring
+        size_t producers;       // live producer rings
+        size_t history_size;
+    };
+
+    EventStats getStats() const;
+
 private:
     EventManager() = default;
 
-    struct ListenerEntry {
-        std::weak_ptr<EventListener> listener;
-        EventPriority priority;
-    };
+    using ListenerMap = std::unordered_map<EventType, std::vector<std::weak_ptr<EventListener>>>;
+
+    EventRing& localRing();
+    void startDispatcher();
+    void dispatchLoop();
 
-    std::unordered_map<EventType, std::vector<ListenerEntry>> listeners_;
-    std::vector<std::shared_ptr<Event>> event_history_;
-    EventPriority min_priority_{EventPriority::LOW};
-    std::vector<EventType> filtered_types_;
-    
-    mutable std::mutex mutex_;
+    // Move queued records to history and listeners; true if any were found
+    bool drain();
+    void addToHistory(const EventRecord& record);
+
+    // producer rings
+    std::vector<std::shared_ptr<EventRing>> rings_;
+    mutable std::mutex rings_mutex_;
+
+    // listeners, replaced on registration so delivery needs no lock per event
+    std::shared_ptr<const ListenerMap> listeners_{std::make_shared<ListenerMap>()};
+    std::mutex listeners_mutex_;
+
+    // time-ordered history of the most recent records
+    std::deque<EventRecord> event_history_;
+    size_t history_capacity_{65536};
+    mutable std::mutex history_mutex_;
+
+    std::atomic<int> min_priority_{static_cast<int>(EventPriority::LOW)};
+    std::atomic<uint32_t> filtered_types_{0};
+
+    // dispatcher, the only consumer of the rings
+    std::thread dispatcher_;
+    std::once_flag dispatcher_started_;
+    std::vector<std::shared_ptr<EventRing>> dispatcher_rings_;
+    std::vector<EventRecord> batch_;
+    bool stopping_{false};
+    size_t flush_waiters_{0};
+    std::mutex mutex_;
     std::condition_variable condition_;
+    std::condition_variable flushed_condition_;
+
+    std::atomic<size_t> delivered_{0};
+    std::atomic<size_t> dropped_{0};
 };
 
 } // namespace runtime
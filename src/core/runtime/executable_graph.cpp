@@ -0,0 +1,450 @@
+#include "executable_graph.hpp"
+#include "task.hpp"
+#include "core/memory_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+constexpr size_t kScratchAlignment = 64;
+constexpr size_t kNoNode = static_cast<size_t>(-1);
+
+// Early transfers go ahead of all compute
+constexpr size_t kEarlyTier = static_cast<size_t>(TaskPriority::HIGH);
+
+void prefetchInputs(const Task& task, size_t max_bytes) {
+#if defined(__GNUC__)
+    for (const auto& input : task.getInputs()) {
+        const char* data = static_cast<const char*>(input.buffer);
+        size_t bytes = std::min(input.bytes, max_bytes);
+        for (size_t offset = 0; offset < bytes; offset += kScratchAlignment) {
+            __builtin_prefetch(data + offset, 0, 3);
+        }
+    }
+#else
+    (void)task;
+    (void)max_bytes;
+#endif
+}
+
+size_t alignScratch(size_t size) {
+    return (size + kScratchAlignment - 1) / kScratchAlignment * kScratchAlignment;
+}
+
+} // namespace
+
+std::shared_ptr<ExecutableGraph> ExecutableGraph::capture(Scheduler& scheduler,
+                                                          const TaskGraph& graph,
+                                                          size_t num_arguments) {
+    return std::shared_ptr<ExecutableGraph>(new ExecutableGraph(scheduler, graph, num_arguments));
+}
+
+ExecutableGraph::ExecutableGraph(Scheduler& scheduler, const TaskGraph& graph, size_t num_arguments)
+    : scheduler_(scheduler)
+    , arguments_(num_arguments, nullptr)
+{
+    {
+        std::lock_guard<std::mutex> lock(graph.graph_mutex_);
+        size_t count = graph.nodes_.size();
+        tasks_.reserve(count);
+        initial_pending_.reserve(count);
+        successor_offsets_.reserve(count + 1);
+        successor_offsets_.push_back(0);
+        for (const auto& node : graph.nodes_) {
+            tasks_.push_back(node.task);
+            initial_pending_.push_back(node.num_dependencies);
+            successors_.insert(successors_.end(), node.successors.begin(), node.successors.end());
+            successor_offsets_.push_back(successors_.size());
+        }
+    }
+
+    pending_.reset(new std::atomic<size_t>[tasks_.size()]);
+    poisoned_.reset(new std::atomic<bool>[tasks_.size()]);
+    early_.reset(new std::atomic<bool>[tasks_.size()]);
+    items_.reserve(tasks_.size());
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        items_.emplace_back(this, i);
+        if (initial_pending_[i] == 0) {
+            roots_.push_back(i);
+        }
+    }
+    plan();
+}
+
+ExecutableGraph::~ExecutableGraph() {
+    // The policy may key per-node state by task address; drop it with the
+    // graph, unless that policy has since been replaced and destroyed
+    std::lock_guard<std::mutex> lock(scheduler_.policy_mutex_);
+    if (prepared_policy_ != nullptr && scheduler_.policy_generation_ == policy_generation_) {
+        prepared_policy_->releaseGraph(GraphTopology{tasks_, successor_offsets_, successors_});
+    }
+    std::free(scratch_);
+}
+
+void ExecutableGraph::plan() {
+    size_t count = tasks_.size();
+    size_t num_workers = std::max<size_t>(scheduler_.getNumWorkers(), 1);
+
+    // Kahn's algorithm: validates the graph and yields a topological order
+    std::vector<size_t> pending(initial_pending_);
+    std::vector<size_t> order;
+    std::vector<size_t> ready(roots_.rbegin(), roots_.rend());
+    order.reserve(count);
+    while (!ready.empty()) {
+        size_t index = ready.back();
+        ready.pop_back();
+        order.push_back(index);
+        for (size_t e = successor_offsets_[index]; e < successor_offsets_[index + 1]; ++e) {
+            if (--pending[successors_[e]] == 0) {
+                ready.push_back(successors_[e]);
+            }
+        }
+    }
+    if (order.size() != count) {
+        throw std::invalid_argument("Task graph contains a dependency cycle");
+    }
+
+    // A transfer is needed at the position of its earliest consumer
+    order_ = order;
+    positions_.resize(count);
+    for (size_t position = 0; position < count; ++position) {
+        positions_[order[position]] = position;
+    }
+    first_consumers_.assign(count, kNoNode);
+    std::vector<size_t> consumed_counts(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (dynamic_cast<const MemoryTransferTask*>(tasks_[i].get()) == nullptr) {
+            continue;
+        }
+        for (size_t e = successor_offsets_[i]; e < successor_offsets_[i + 1]; ++e) {
+            size_t consumer = successors_[e];
+            if (first_consumers_[i] == kNoNode ||
+                positions_[consumer] < positions_[first_consumers_[i]]) {
+                first_consumers_[i] = consumer;
+            }
+        }
+        if (first_consumers_[i] != kNoNode) {
+            consumed_counts[first_consumers_[i]]++;
+        }
+    }
+    consumed_offsets_.assign(count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        consumed_offsets_[i + 1] = consumed_offsets_[i] + consumed_counts[i];
+    }
+    consumed_.resize(consumed_offsets_[count]);
+    for (size_t i = 0; i < count; ++i) {
+        if (first_consumers_[i] != kNoNode) {
+            size_t consumer = first_consumers_[i];
+            consumed_[consumed_offsets_[consumer + 1] - consumed_counts[consumer]--] = i;
+        }
+    }
+
+    // Each node hands its chain to at most one successor, so a chain is a
+    // path and its nodes never run concurrently
+    constexpr size_t kNoChain = kNoNode;
+    chain_of_.assign(count, kNoChain);
+    std::vector<size_t> chain_scratch;
+    for (size_t index : order) {
+        if (chain_of_[index] == kNoChain) {
+            // A chain follows the locality hint of its first node
+            size_t worker = scheduler_.selectWorker(tasks_[index]->getLocalityHint());
+            if (worker == Scheduler::kNotAWorker) {
+                worker = chain_workers_.size() % num_workers;
+            }
+            chain_of_[index] = chain_workers_.size();
+            chain_workers_.push_back(worker);
+            chain_scratch.push_back(0);
+        }
+        for (size_t e = successor_offsets_[index]; e < successor_offsets_[index + 1]; ++e) {
+            if (chain_of_[successors_[e]] == kNoChain) {
+                chain_of_[successors_[e]] = chain_of_[index];
+                break;
+            }
+        }
+    }
+
+    // A chain's scratch region fits its largest ComputeTask scratch requirement
+    scratch_sizes_.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (auto compute = dynamic_cast<const ComputeTask*>(tasks_[i].get())) {
+            scratch_sizes_[i] = compute->getScratchRequirement();
+            if (scratch_sizes_[i] > SIZE_MAX / 2) {
+                throw std::length_error("Scratch requirement of task '" +
+                                        tasks_[i]->getName() + "' is too large");
+            }
+            size_t& chain_size = chain_scratch[chain_of_[i]];
+            chain_size = std::max(chain_size, alignScratch(scratch_sizes_[i]));
+        }
+    }
+    scratch_offsets_.resize(chain_scratch.size());
+    for (size_t chain = 0; chain < chain_scratch.size(); ++chain) {
+        if (chain_scratch[chain] > SIZE_MAX - scratch_bytes_) {
+            throw std::length_error("Executable graph scratch exceeds the address space");
+        }
+        scratch_offsets_[chain] = scratch_bytes_;
+        scratch_bytes_ += chain_scratch[chain];
+    }
+    if (scratch_bytes_ > 0) {
+        scratch_ = std::aligned_alloc(kScratchAlignment, scratch_bytes_);
+        if (scratch_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    // Last, so a failed capture leaves nothing behind in the policy
+    reprioritize();
+}
+
+void ExecutableGraph::reprioritize() {
+    if (isRunning()) {
+        throw std::runtime_error("Cannot reprioritize a running graph");
+    }
+    std::lock_guard<std::mutex> lock(scheduler_.policy_mutex_);
+    SchedulingPolicy* policy = scheduler_.scheduling_policy_.get();
+    if (policy != nullptr) {
+        policy->prepareGraph(GraphTopology{tasks_, successor_offsets_, successors_});
+    }
+    prepared_policy_ = policy;
+    policy_generation_ = scheduler_.policy_generation_;
+    tiers_.resize(tasks_.size());
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        tiers_[i] = policy != nullptr
+            ? policy->selectTier(*tasks_[i])
+            : static_cast<size_t>(tasks_[i]->getPriority());
+    }
+}
+
+void ExecutableGraph::setPrefetchConfig(const PrefetchConfig& config) {
+    if (isRunning()) {
+        throw std::runtime_error("Cannot change the prefetch config of a running graph");
+    }
+    prefetch_config_ = config;
+}
+
+void ExecutableGraph::addSafePoint(core::DevicePool* pool) {
+    if (pool == nullptr) {
+        throw std::invalid_argument("Safe point pool must not be null");
+    }
+    if (isRunning()) {
+        throw std::runtime_error("Cannot add a safe point to a running graph");
+    }
+    pools_.push_back(pool);
+}
+
+void ExecutableGraph::bindArgument(size_t slot, void* value) {
+    if (slot >= arguments_.size()) {
+        throw std::out_of_range("Graph argument slot " + std::to_string(slot) +
+                                " out of range, graph has " +
+                                std::to_string(arguments_.size()));
+    }
+    if (isRunning()) {
+        throw std::runtime_error("Cannot rebind arguments of a running graph");
+    }
+    arguments_[slot] = value;
+}
+
+std::future<void> ExecutableGraph::launch() {
+    // Keeps shutdown() from tearing down the queues while roots are dispatched
+    Scheduler::DispatchGuard guard(scheduler_);
+    if (running_.exchange(true, std::memory_order_acq_rel)) {
+        throw std::runtime_error("Executable graph is already running");
+    }
+
+    done_ = std::promise<void>();
+    std::future<void> future = done_.get_future();
+    error_ = nullptr;
+    launches_++;
+    if (tasks_.empty()) {
+        running_.store(false, std::memory_order_release);
+        done_.set_value();
+        return future;
+    }
+
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        pending_[i].store(initial_pending_[i], std::memory_order_relaxed);
+        poisoned_[i].store(false, std::memory_order_relaxed);
+        early_[i].store(false, std::memory_order_relaxed);
+        tasks_[i]->reset();
+    }
+    started_.store(0, std::memory_order_relaxed);
+    early_bytes_.store(0, std::memory_order_relaxed);
+    remaining_.store(tasks_.size(), std::memory_order_relaxed);
+    keep_alive_ = shared_from_this();
+
+    for (size_t index : roots_) {
+        dispatch(index);
+    }
+    return future;
+}
+
+void ExecutableGraph::cancel() {
+    if (!isRunning()) {
+        return;
+    }
+    for (const auto& task : tasks_) {
+        task->cancel();
+    }
+}
+
+ExecutableGraph::GraphStats ExecutableGraph::getStats() const {
+    GraphStats stats{};
+    stats.nodes = tasks_.size();
+    stats.edges = successors_.size();
+    stats.chains = chain_workers_.size();
+    stats.scratch_bytes = scratch_bytes_;
+    stats.launches = launches_;
+    stats.cancelled_nodes = cancelled_nodes_.load(std::memory_order_relaxed);
+    stats.early_transfers = early_transfers_.load(std::memory_order_relaxed);
+    stats.compactions = compactions_;
+    return stats;
+}
+
+void ExecutableGraph::dispatch(size_t index) {
+    const Task& task = *tasks_[index];
+    tasks_[index]->markEnqueued();
+    if (issueEarly(index)) {
+        // Any idle worker may run it while the chain's worker computes
+        early_transfers_.fetch_add(1, std::memory_order_relaxed);
+        scheduler_.dispatchTask(&items_[index], task, kEarlyTier, Scheduler::kNotAWorker);
+        return;
+    }
+    scheduler_.dispatchTask(&items_[index], task, tiers_[index], chain_workers_[chain_of_[index]]);
+}
+
+bool ExecutableGraph::issueEarly(size_t index) {
+    size_t consumer = first_consumers_[index];
+    if (consumer == kNoNode || prefetch_config_.lookahead == 0 ||
+        positions_[consumer] >= started_.load(std::memory_order_relaxed) + prefetch_config_.lookahead) {
+        return false;
+    }
+    size_t bytes = static_cast<const MemoryTransferTask&>(*tasks_[index]).getDataSize();
+    size_t used = early_bytes_.load(std::memory_order_relaxed);
+    do {
+        if (used + bytes > prefetch_config_.memory_budget) {
+            return false;
+        }
+    } while (!early_bytes_.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+    early_[index].store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void ExecutableGraph::consumeEarly(size_t index) {
+    for (size_t e = consumed_offsets_[index]; e < consumed_offsets_[index + 1]; ++e) {
+        size_t transfer = consumed_[e];
+        if (early_[transfer].exchange(false, std::memory_order_relaxed)) {
+            size_t bytes = static_cast<const MemoryTransferTask&>(*tasks_[transfer]).getDataSize();
+            early_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ExecutableGraph::execute(size_t index, ExecutionContext& context) {
+    size_t position = started_.fetch_add(1, std::memory_order_relaxed);
+    consumeEarly(index);
+
+    // Start pulling in the inputs of the node lookahead positions out; the
+    // lines land in the shared cache levels whichever worker runs it
+    size_t ahead = position + prefetch_config_.lookahead;
+    if (prefetch_config_.lookahead > 0 && prefetch_config_.prefetch_bytes > 0 &&
+        ahead < order_.size()) {
+        prefetchInputs(*tasks_[order_[ahead]], prefetch_config_.prefetch_bytes);
+    }
+
+    // Nodes can nest when a waiting task helps run other work
+    void* outer_scratch = context.scratch_;
+    size_t outer_scratch_size = context.scratch_size_;
+    const std::vector<void*>* outer_arguments = context.arguments_;
+
+    context.scratch_ = scratch_sizes_[index] > 0
+        ? static_cast<uint8_t*>(scratch_) + scratch_offsets_[chain_of_[index]]
+        : nullptr;
+    context.scratch_size_ = scratch_sizes_[index];
+    context.arguments_ = &arguments_;
+    std::exception_ptr error = scheduler_.executeTask(tasks_[index], context);
+    context.scratch_ = outer_scratch;
+    context.scratch_size_ = outer_scratch_size;
+    context.arguments_ = outer_arguments;
+
+    if (error) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+            error_ = error;
+        }
+    }
+
+    const Task& task = *tasks_[index];
+    if (task.getStatus() == TaskStatus::CANCELLED) {
+        cancelled_nodes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    release(index, error || task.getStatus() == TaskStatus::CANCELLED ||
+                   poisoned_[index].load(std::memory_order_relaxed));
+}
+
+void ExecutableGraph::release(size_t index, bool failed) {
+    // Cancelled nodes are retired here, in this loop, so a failure costs
+    // O(affected nodes) and none of them passes through the queues
+    std::vector<size_t> cancelled;
+    for (;;) {
+        // A successor is dispatched by whichever predecessor finishes last
+        for (size_t e = successor_offsets_[index]; e < successor_offsets_[index + 1]; ++e) {
+            size_t successor = successors_[e];
+            if (failed) {
+                poisoned_[successor].store(true, std::memory_order_relaxed);
+            }
+            if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Task& next = *tasks_[successor];
+                if (poisoned_[successor].load(std::memory_order_relaxed) &&
+                    (next.tryCancel() || next.isCancelled())) {
+                    cancelled.push_back(successor);
+                } else {
+                    dispatch(successor);
+                }
+            }
+        }
+
+        // Nothing below may touch the graph unless this was the last node
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Safe point: no node runs and no launch can start until running_ clears
+            std::exception_ptr failure = error_;
+            for (core::DevicePool* pool : pools_) {
+                try {
+                    compactions_ += pool->safePoint();
+                } catch (...) {
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+            }
+            // The graph may be destroyed as soon as the promise is
+            // fulfilled, so the worker drops its reference first
+            std::promise<void> done = std::move(done_);
+            std::shared_ptr<ExecutableGraph> self = std::move(keep_alive_);
+            running_.store(false, std::memory_order_release);
+            self.reset();
+            if (failure) {
+                done.set_exception(failure);
+            } else {
+                done.set_value();
+            }
+            return;
+        }
+        if (cancelled.empty()) {
+            return;
+        }
+        index = cancelled.back();
+        cancelled.pop_back();
+        failed = true;
+        consumeEarly(index);
+        cancelled_nodes_.fetch_add(1, std::memory_order_relaxed);
+        scheduler_.metrics_.cancelled_tasks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace runtime
+} // namespace uta
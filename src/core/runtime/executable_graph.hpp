@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace core {
+class DevicePool;
+}
+
+namespace runtime {
+
+// Captured task graph for repeated launches
+//
+// Capture validates a TaskGraph once and freezes its topology, queue tiers,
+// worker placement and scratch memory plan. The graph is split into chains
+// (paths whose nodes run strictly one after another); each chain has a
+// preferred worker and one host scratch region sized for the largest
+// ComputeTask::getScratchRequirement() on it. A launch only resets the
+// dependency counters. Per-iteration inputs are rebound with bindArgument
+// and read through ExecutionContext::getArgument.
+//
+// MemoryTransferTasks whose first consumer is at most PrefetchConfig::lookahead
+// nodes past the launch's progress are queued at the top tier on any worker
+// as soon as they are ready, rather than behind compute on their chain's
+// worker, so the copy overlaps the preceding compute. The bytes of these early
+// transfers are capped by a memory budget and returned when their consumer
+// starts. The budget only caps early issue: transfers outside the window or
+// over budget are not held back but queued like compute on their chain.
+// As each node starts, the worker also software-prefetches the inputs of the
+// node lookahead positions further along in topological order.
+//
+// Device pools attached with addSafePoint() reach a safe point after every
+// launch, once all nodes have finished and before the next launch can start,
+// and compact there if they are fragmented.
+class ExecutableGraph : public std::enable_shared_from_this<ExecutableGraph> {
+public:
+    static std::shared_ptr<ExecutableGraph> capture(Scheduler& scheduler,
+                                                    const TaskGraph& graph,
+                                                    size_t num_arguments = 0);
+
+    ~ExecutableGraph();
+
+    ExecutableGraph(const ExecutableGraph&) = delete;
+    ExecutableGraph& operator=(const ExecutableGraph&) = delete;
+
+    // Only between launches
+    void bindArgument(size_t slot, void* value);
+
+    // One launch at a time; the future holds the first task failure, if any.
+    // Nodes downstream of a failed or cancelled node are cancelled without
+    // running; nodes whose task is not cancellable still run.
+    std::future<void> launch();
+
+    // Cancel every node of the running launch that has not finished;
+    // running kernels see their cancellation token set
+    void cancel();
+
+    struct PrefetchConfig {
+        size_t lookahead = 4;                   // nodes, in topological order; 0 disables
+        size_t memory_budget = 256 << 20;       // bytes of early transfers not yet consumed
+        size_t prefetch_bytes = 16 << 10;       // per input of the node lookahead positions
+                                                // ahead, software-prefetched; 0 disables
+    };
+
+    // Only between launches
+    void setPrefetchConfig(const PrefetchConfig& config);
+    PrefetchConfig getPrefetchConfig() const { return prefetch_config_; }
+
+    // Compact the pool between launches; nodes that keep pool addresses
+    // across launches must pin them. Only between launches
+    void addSafePoint(core::DevicePool* pool);
+
+    // Re-run the scheduling policy over all nodes, e.g. once execution times
+    // have been measured; only between launches
+    void reprioritize();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    size_t size() const { return tasks_.size(); }
+
+    struct GraphStats {
+        size_t nodes;
+        size_t edges;
+        size_t chains;
+        size_t scratch_bytes;
+        size_t launches;
+        size_t cancelled_nodes;     // over all launches
+        size_t early_transfers;     // over all launches
+        size_t compactions;         // at safe points, over all launches
+    };
+
+    GraphStats getStats() const;
+
+private:
+    class NodeItem : public WorkItem {
+    public:
+        NodeItem(ExecutableGraph* graph, size_t index) : graph_(graph), index_(index) {}
+
+        void run(ExecutionContext& context) override {
+            graph_->execute(index_, context);
+        }
+
+        Task* getTask() override { return graph_->tasks_[index_].get(); }
+
+    private:
+        ExecutableGraph* graph_;
+        size_t index_;
+    };
+
+    ExecutableGraph(Scheduler& scheduler, const TaskGraph& graph, size_t num_arguments);
+
+    void plan();
+    void dispatch(size_t index);
+    void execute(size_t index, ExecutionContext& context);
+
+    // Release the node's successors and retire it; successors of a failed
+    // node are cancelled here instead of being queued
+    void release(size_t index, bool failed);
+
+    // Whether a ready transfer node is queued ahead of compute
+    bool issueEarly(size_t index);
+
+    // Return the budget of early transfers the node consumes first
+    void consumeEarly(size_t index);
+
+    Scheduler& scheduler_;
+
+    // frozen topology
+    std::vector<std::shared_ptr<Task>> tasks_;
+    std::vector<size_t> initial_pending_;
+    std::vector<size_t> successor_offsets_;
+    std::vector<size_t> successors_;
+    std::vector<size_t> roots_;
+    std::vector<NodeItem> items_;
+
+    // frozen placement and memory plan
+    std::vector<size_t> tiers_;
+    std::vector<size_t> chain_of_;
+    std::vector<size_t> chain_workers_;
+    std::vector<size_t> scratch_offsets_;    // per chain
+    std::vector<size_t> scratch_sizes_;      // per node
+    void* scratch_{nullptr};
+    size_t scratch_bytes_{0};
+
+    // frozen transfer lookahead plan
+    std::vector<size_t> order_;                 // topological order
+    std::vector<size_t> positions_;             // in topological order
+    std::vector<size_t> first_consumers_;       // per transfer node
+    std::vector<size_t> consumed_offsets_;      // transfers each node consumes first
+    std::vector<size_t> consumed_;
+    PrefetchConfig prefetch_config_;
+
+    // policy that last prepared the graph, valid while the scheduler's
+    // policy generation still matches
+    SchedulingPolicy* prepared_policy_{nullptr};
+    uint64_t policy_generation_{0};
+
+    std::vector<void*> arguments_;
+    std::vector<core::DevicePool*> pools_;
+
+    // launch state
+    std::unique_ptr<std::atomic<size_t>[]> pending_;
+    std::unique_ptr<std::atomic<bool>[]> poisoned_;     // a predecessor failed or was cancelled
+    std::atomic<size_t> cancelled_nodes_{0};
+    std::unique_ptr<std::atomic<bool>[]> early_;        // transfer holds budget
+    std::atomic<size_t> started_{0};
+    std::atomic<size_t> early_bytes_{0};
+    std::atomic<size_t> early_transfers_{0};
+    std::atomic<size_t> remaining_{0};
+    std::atomic<bool> running_{false};
+    size_t launches_{0};
+    size_t compactions_{0};
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+    std::promise<void> done_;
+    std::shared_ptr<ExecutableGraph> keep_alive_;
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,329 @@
+#include "host_stream.hpp"
+#include "copy_engine.hpp"
+#include <uta/uta.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+constexpr size_t kStreamTier = static_cast<size_t>(TaskPriority::NORMAL);
+
+} // namespace
+
+// Event state
+
+uint64_t EventState::beginRecord() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ++generation_;
+}
+
+void EventState::complete(uint64_t generation) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation <= completed_) {
+            return;
+        }
+        completed_ = generation;
+        timestamp_ = std::chrono::steady_clock::now();
+        has_timestamp_ = true;
+        auto waiting = callbacks_.begin();
+        for (auto& entry : callbacks_) {
+            if (entry.first <= generation) {
+                ready.push_back(std::move(entry.second));
+            } else {
+                *waiting++ = std::move(entry);
+            }
+        }
+        callbacks_.erase(waiting, callbacks_.end());
+    }
+    condition_.notify_all();
+    for (auto& callback : ready) {
+        callback();
+    }
+}
+
+uint64_t EventState::currentGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+bool EventState::isComplete(uint64_t generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_ >= generation;
+}
+
+bool EventState::query() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_ >= generation_;
+}
+
+void EventState::synchronize() {
+    uint64_t generation = currentGeneration();
+    if (Scheduler::currentWorker() != Scheduler::kNotAWorker) {
+        // Blocking a worker could starve the stream this waits for
+        while (!isComplete(generation)) {
+            if (!Scheduler::getInstance().runPendingWork()) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this, generation] { return completed_ >= generation; });
+}
+
+void EventState::onComplete(uint64_t generation, std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (completed_ < generation) {
+            callbacks_.emplace_back(generation, std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+std::chrono::steady_clock::time_point EventState::getTimestamp() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_timestamp_) {
+        throw std::runtime_error("Event has not completed");
+    }
+    return timestamp_;
+}
+
+// Stream queue
+
+StreamQueue::StreamQueue()
+    : head_(&stub_)
+    , tail_(&stub_)
+{}
+
+StreamQueue::~StreamQueue() {
+    delete blocked_;
+    while (Command* command = pop()) {
+        delete command;
+    }
+}
+
+void StreamQueue::enqueue(std::function<void()> function) {
+    Command* command = new Command();
+    command->kind = Command::Kind::RUN;
+    command->function = std::move(function);
+    push(command);
+}
+
+void StreamQueue::enqueueRecord(std::shared_ptr<EventState> event, uint64_t generation) {
+    Command* command = new Command();
+    command->kind = Command::Kind::RECORD;
+    command->event = std::move(event);
+    command->generation = generation;
+    push(command);
+}
+
+void StreamQueue::enqueueWait(std::shared_ptr<EventState> event, uint64_t generation) {
+    Command* command = new Command();
+    command->kind = Command::Kind::WAIT;
+    command->event = std::move(event);
+    command->generation = generation;
+    push(command);
+}
+
+std::exception_ptr StreamQueue::takeError() {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return std::exchange(error_, nullptr);
+}
+
+void StreamQueue::push(Command* command) {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    command->next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = head_.exchange(command, std::memory_order_acq_rel);
+    previous->next.store(command, std::memory_order_release);
+
+    // Whoever takes the count from zero owns draining until it drops back
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        keep_alive_ = shared_from_this();
+        schedule();
+    }
+}
+
+StreamQueue::Command* StreamQueue::pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        tail_ = next;
+        return static_cast<Command*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+        // A producer is between exchanging head_ and linking its node
+        return nullptr;
+    }
+    // Put the stub back so the last command can be taken
+    stub_.next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = head_.exchange(&stub_, std::memory_order_acq_rel);
+    previous->next.store(&stub_, std::memory_order_release);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        tail_ = next;
+        return static_cast<Command*>(tail);
+    }
+    return nullptr;
+}
+
+void StreamQueue::schedule() {
+    // Without a running scheduler the caller drains the queue itself
+    Scheduler& scheduler = Scheduler::getInstance();
+    if (scheduler.getNumWorkers() == 0 || !scheduler.tryDispatch(&drainer_, kStreamTier)) {
+        drain();
+    }
+}
+
+void StreamQueue::drain() {
+    for (;;) {
+        Command* command = std::exchange(blocked_, nullptr);
+        if (command == nullptr) {
+            // Counted commands may still be mid-push
+            while ((command = pop()) == nullptr) {
+                std::this_thread::yield();
+            }
+        }
+        if (!execute(*command)) {
+            // Parked; the event's completion resumes draining with this command
+            return;
+        }
+        delete command;
+
+        std::shared_ptr<StreamQueue> self = std::move(keep_alive_);
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Idle; this may release the last reference
+            return;
+        }
+        keep_alive_ = std::move(self);
+    }
+}
+
+bool StreamQueue::execute(Command& command) {
+    switch (command.kind) {
+    case Command::Kind::RUN:
+        try {
+            command.function();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        finished_.fetch_add(1, std::memory_order_release);
+        return true;
+    case Command::Kind::RECORD:
+        // Whoever the event releases must see this stream as done up to here
+        finished_.fetch_add(1, std::memory_order_release);
+        command.event->complete(command.generation);
+        return true;
+    case Command::Kind::WAIT:
+        if (command.event->isComplete(command.generation)) {
+            finished_.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+        // Set before registering: the callback may resume draining at once
+        blocked_ = &command;
+        command.event->onComplete(command.generation,
+                                  [self = keep_alive_] { self->schedule(); });
+        return false;
+    }
+    return true;
+}
+
+} // namespace runtime
+
+// Stream
+
+Stream::Stream()
+    : queue_(std::make_shared<runtime::StreamQueue>())
+{}
+
+void Stream::synchronize() {
+    Event marker;
+    marker.record(*this);
+    marker.synchronize();
+    if (std::exception_ptr error = queue_->takeError()) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool Stream::query() {
+    return queue_->idle();
+}
+
+void Stream::wait(Event& event) {
+    queue_->enqueueWait(event.state_, event.state_->currentGeneration());
+}
+
+void Stream::memcpy(void* dst, const void* src, size_t size) {
+    // The chunks run on the scheduler while the stream parks on their completion
+    auto copied = std::make_shared<runtime::EventState>();
+    uint64_t generation = copied->beginRecord();
+    queue_->enqueue([dst, src, size, copied, generation] {
+        runtime::CopyEngine::getInstance().copyAsync(dst, src, size, [copied, generation] {
+            copied->complete(generation);
+        });
+    });
+    queue_->enqueueWait(std::move(copied), generation);
+}
+
+void Stream::memset(void* ptr, int value, size_t size) {
+    queue_->enqueue([ptr, value, size] { std::memset(ptr, value, size); });
+}
+
+void Stream::launch(const std::function<void()>& kernel) {
+    queue_->enqueue(kernel);
+}
+
+void Stream::addCallback(std::function<void()> callback) {
+    queue_->enqueue(std::move(callback));
+}
+
+// Event
+
+Event::Event()
+    : state_(std::make_shared<runtime::EventState>())
+{}
+
+void Event::record(Stream& stream) {
+    stream.queue_->enqueueRecord(state_, state_->beginRecord());
+}
+
+void Event::synchronize() {
+    state_->synchronize();
+}
+
+bool Event::query() {
+    return state_->query();
+}
+
+float Event::elapsed(const Event& start) {
+    if (!state_->query() || !start.state_->query()) {
+        throw std::runtime_error("Event::elapsed needs both events completed");
+    }
+    std::chrono::duration<float, std::milli> duration =
+        state_->getTimestamp() - start.state_->getTimestamp();
+    return duration.count();
+}
+
+void Event::addCallback(std::function<void()> callback) {
+    state_->onComplete(state_->currentGeneration(), std::move(callback));
+}
+
+} // namespace uta
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// Completion state behind uta::Event
+//
+// Every record() starts a new generation that completes when the recording
+// stream reaches it. Waits and callbacks are tied to the generation that
+// was current when they were issued, so re-recording an event does not
+// release earlier waiters late or later ones early.
+class EventState {
+public:
+    // Start a new generation, returns its number
+    uint64_t beginRecord();
+
+    // Called by the stream when it reaches the recorded point
+    void complete(uint64_t generation);
+
+    uint64_t currentGeneration() const;
+    bool isComplete(uint64_t generation) const;
+    bool query() const;
+
+    // Blocks; a scheduler worker runs other queued work meanwhile
+    void synchronize();
+
+    // Runs callback once `generation` has completed, immediately if it has
+    void onComplete(uint64_t generation, std::function<void()> callback);
+
+    // Completion time of the last completed generation; throws if none
+    std::chrono::steady_clock::time_point getTimestamp() const;
+
+private:
+    uint64_t generation_{0};
+    uint64_t completed_{0};
+    bool has_timestamp_{false};
+    std::chrono::steady_clock::time_point timestamp_;
+    std::vector<std::pair<uint64_t, std::function<void()>>> callbacks_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+// In-order command queue behind uta::Stream
+//
+// Any thread may enqueue without locks (intrusive MPSC queue). The first
+// command queued on an idle stream dispatches a drain item to the
+// scheduler; the drainer runs commands in order until the queue is empty,
+// so different streams run concurrently on different workers. A wait on an
+// event that has not completed parks the stream without holding a worker;
+// the event's completion dispatches the drainer again. Without scheduler
+// workers, commands run on the thread that makes them runnable.
+class StreamQueue : public std::enable_shared_from_this<StreamQueue> {
+public:
+    StreamQueue();
+    ~StreamQueue();
+
+    StreamQueue(const StreamQueue&) = delete;
+    StreamQueue& operator=(const StreamQueue&) = delete;
+
+    void enqueue(std::function<void()> function);
+    void enqueueRecord(std::shared_ptr<EventState> event, uint64_t generation);
+    void enqueueWait(std::shared_ptr<EventState> event, uint64_t generation);
+
+    // true when every command queued so far has run
+    bool idle() const {
+        return finished_.load(std::memory_order_acquire) ==
+               submitted_.load(std::memory_order_acquire);
+    }
+
+    // First exception thrown by a command since the last call, if any
+    std::exception_ptr takeError();
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+    };
+
+    struct Command : Node {
+        enum class Kind { RUN, RECORD, WAIT };
+
+        Kind kind;
+        std::function<void()> function;
+        std::shared_ptr<EventState> event;
+        uint64_t generation;
+    };
+
+    class Drainer : public WorkItem {
+    public:
+        explicit Drainer(StreamQueue* queue) : queue_(queue) {}
+        void run(ExecutionContext&) override { queue_->drain(); }
+
+    private:
+        StreamQueue* queue_;
+    };
+
+    void push(Command* command);
+    Command* pop();
+    void schedule();
+    void drain();
+
+    // Returns false if the stream must park until the command's event completes
+    bool execute(Command& command);
+
+    // MPSC queue: producers exchange head_, the drainer owns tail_
+    std::atomic<Node*> head_;
+    Node* tail_;
+    Node stub_;
+
+    std::atomic<size_t> pending_{0};               // drain token: held while nonzero
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> finished_{0};             // counted before a record fires
+    Command* blocked_{nullptr};                     // parked wait, resumed first
+    std::shared_ptr<StreamQueue> keep_alive_;       // held while commands are pending
+    Drainer drainer_{this};
+
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,135 @@
+#include "latency_histogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace uta {
+namespace runtime {
+
+// Latency histogram
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+    value = std::min<uint64_t>(value, (uint64_t(1) << kMaxValueBits) - 1);
+    if (value < 2 * kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    // Octave from the highest set bit, then the next kSubBucketBits bits
+    size_t shift = static_cast<size_t>(63 - __builtin_clzll(value)) - kSubBucketBits;
+    return kSubBuckets * shift + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t bucket) {
+    if (bucket < 2 * kSubBuckets) {
+        return bucket;
+    }
+    size_t shift = bucket / kSubBuckets - 1;
+    return static_cast<uint64_t>(bucket % kSubBuckets + kSubBuckets) << shift;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    counts_[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::addTo(Snapshot& snapshot) const {
+    // Counts are summed from the buckets so percentiles stay consistent
+    for (size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        uint64_t count = counts_[bucket].load(std::memory_order_relaxed);
+        snapshot.counts[bucket] += count;
+        snapshot.count += count;
+    }
+    snapshot.sum += sum_.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Snapshot::add(const Snapshot& other) {
+    for (size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        counts[bucket] += other.counts[bucket];
+    }
+    count += other.count;
+    sum += other.sum;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    q = std::min(std::max(q, 0.0), 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            // Middle of the bucket
+            uint64_t lower = bucketLowerBound(bucket);
+            uint64_t upper = bucket + 1 < kNumBuckets ? bucketLowerBound(bucket + 1) : lower + 1;
+            return lower + (upper - lower - 1) / 2;
+        }
+    }
+    return bucketLowerBound(kNumBuckets - 1);
+}
+
+// Task latency table
+
+TaskLatencyTable::~TaskLatencyTable() {
+    for (auto& slot : slots_) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+    delete overflow_.load(std::memory_order_relaxed);
+}
+
+TaskLatencyTable::Entry& TaskLatencyTable::claim(std::atomic<Entry*>& slot,
+                                                  const std::string& name) {
+    Entry* entry = new Entry(name);
+    Entry* expected = nullptr;
+    if (slot.compare_exchange_strong(expected, entry, std::memory_order_acq_rel)) {
+        return *entry;
+    }
+    // Another thread claimed the slot first
+    delete entry;
+    return *expected;
+}
+
+TaskLatencyTable::Entry& TaskLatencyTable::find(const std::string& name) {
+    size_t start = std::hash<std::string>()(name) % kMaxTaskNames;
+    for (size_t i = 0; i < kMaxTaskNames; ++i) {
+        std::atomic<Entry*>& slot = slots_[(start + i) % kMaxTaskNames];
+        Entry* entry = slot.load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            entry = &claim(slot, name);
+        }
+        if (entry->name == name) {
+            return *entry;
+        }
+    }
+    Entry* overflow = overflow_.load(std::memory_order_acquire);
+    return overflow != nullptr ? *overflow : claim(overflow_, kOverflowName);
+}
+
+void TaskLatencyTable::record(const std::string& name, uint64_t wait_ns, uint64_t execution_ns) {
+    Entry& entry = find(name);
+    entry.wait_time.record(wait_ns);
+    entry.execution_time.record(execution_ns);
+}
+
+void TaskLatencyTable::addTo(std::unordered_map<std::string, TaskSnapshot>& snapshots) const {
+    auto add = [&snapshots](const Entry* entry) {
+        if (entry != nullptr) {
+            TaskSnapshot& snapshot = snapshots[entry->name];
+            entry->wait_time.addTo(snapshot.wait_time);
+            entry->execution_time.addTo(snapshot.execution_time);
+        }
+    };
+    for (const auto& slot : slots_) {
+        add(slot.load(std::memory_order_acquire));
+    }
+    add(overflow_.load(std::memory_order_acquire));
+}
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uta {
+namespace runtime {
+
+// Log-linear latency histogram
+//
+// Each power of two is split into kSubBuckets linear buckets, so a recorded
+// value is off by at most 1/kSubBuckets of itself. Values are nanoseconds
+// up to 2^kMaxValueBits (about 18 minutes), larger ones are clamped.
+// Recording is one relaxed fetch_add per counter; snapshots may be taken
+// while other threads record.
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kMaxValueBits = 40;
+    static constexpr size_t kNumBuckets = kSubBuckets * (kMaxValueBits - kSubBucketBits + 1);
+
+    // Merged, non-atomic copy of one or more histograms
+    struct Snapshot {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(kNumBuckets, 0);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        void add(const Snapshot& other);
+
+        // Nanoseconds at quantile q in [0, 1], 0 when empty
+        uint64_t percentile(double q) const;
+        double mean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+
+    // Add this histogram's counts into snapshot
+    void addTo(Snapshot& snapshot) const;
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketLowerBound(size_t bucket);
+
+private:
+    std::atomic<uint64_t> counts_[kNumBuckets];
+    std::atomic<uint64_t> sum_{0};
+};
+
+// Wait and run time histograms by task name
+//
+// A fixed number of name slots is filled lock-free on first use; names
+// beyond kMaxTaskNames share one overflow entry, so memory stays bounded.
+// The scheduler keeps one table per worker and merges them on demand.
+class TaskLatencyTable {
+public:
+    static constexpr size_t kMaxTaskNames = 64;
+    static constexpr const char* kOverflowName = "(other)";
+
+    struct TaskSnapshot {
+        LatencyHistogram::Snapshot wait_time;
+        LatencyHistogram::Snapshot execution_time;
+    };
+
+    TaskLatencyTable() = default;
+    ~TaskLatencyTable();
+
+    TaskLatencyTable(const TaskLatencyTable&) = delete;
+    TaskLatencyTable& operator=(const TaskLatencyTable&) = delete;
+
+    void record(const std::string& name, uint64_t wait_ns, uint64_t execution_ns);
+
+    // Add all entries into snapshots, keyed by task name
+    void addTo(std::unordered_map<std::string, TaskSnapshot>& snapshots) const;
+
+private:
+    struct Entry {
+        explicit Entry(std::string entry_name) : name(std::move(entry_name)) {}
+
+        std::string name;
+        LatencyHistogram wait_time;
+        LatencyHistogram execution_time;
+    };
+
+    Entry& find(const std::string& name);
+    Entry& claim(std::atomic<Entry*>& slot, const std::string& name);
+
+    std::atomic<Entry*> slots_[kMaxTaskNames] = {};
+    std::atomic<Entry*> overflow_{nullptr};
+};
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// Half-open index range [begin, end)
+struct Range {
+    size_t begin;
+    size_t end;
+
+    size_t size() const { return end > begin ? end - begin : 0; }
+};
+
+// Upper bound on scheduler workers joining a single loop
+constexpr size_t kMaxLoopHelpers = 63;
+
+namespace detail {
+
+// Shared state of one parallel loop; lives on the calling thread's stack
+class LoopState {
+public:
+    LoopState(Range range, size_t grain, size_t participants)
+        : next_(range.begin)
+        , end_(range.end)
+        , grain_(grain)
+        , participants_(participants)
+    {}
+
+    // Guided self-scheduling: large chunks first, shrinking towards the grain
+    bool claim(Range& chunk) {
+        size_t current = next_.load(std::memory_order_relaxed);
+        while (current < end_) {
+            size_t remaining = end_ - current;
+            size_t size = std::min(remaining, std::max(grain_, remaining / (2 * participants_)));
+            if (next_.compare_exchange_weak(current, current + size, std::memory_order_relaxed)) {
+                chunk = Range{current, current + size};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Keeps the first error and stops handing out chunks
+    void fail(std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = error;
+            }
+        }
+        next_.store(end_, std::memory_order_relaxed);
+    }
+
+    void setHelpers(size_t count) {
+        outstanding_.store(count, std::memory_order_relaxed);
+    }
+
+    void helperDone() {
+        outstanding_.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Runs other queued work until every helper has finished with this state
+    void wait() {
+        Scheduler& scheduler = Scheduler::getInstance();
+        while (outstanding_.load(std::memory_order_acquire) != 0) {
+            if (!scheduler.runPendingWork()) {
+                std::this_thread::yield();
+            }
+        }
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    std::atomic<size_t> next_;
+    size_t end_;
+    size_t grain_;
+    size_t participants_;
+    std::atomic<size_t> outstanding_{0};
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+};
+
+// Work item that joins a loop as participant `slot`
+template<typename Participant>
+class LoopHelper : public WorkItem {
+public:
+    void setup(LoopState* state, Participant* participant, size_t slot) {
+        state_ = state;
+        participant_ = participant;
+        slot_ = slot;
+    }
+
+    void run(ExecutionContext&) override {
+        LoopState* state = state_;
+        (*participant_)(slot_);
+        // The loop may return as soon as this lands; touch nothing afterwards
+        state->helperDone();
+    }
+
+private:
+    LoopState* state_{nullptr};
+    Participant* participant_{nullptr};
+    size_t slot_{0};
+};
+
+// Number of workers worth waking for `chunks` grains of work
+inline size_t loopHelpers(size_t chunks) {
+    Scheduler& scheduler = Scheduler::getInstance();
+    size_t workers = scheduler.getNumWorkers();
+    if (workers > 0 && Scheduler::currentWorker() != Scheduler::kNotAWorker) {
+        workers--;
+    }
+    return std::min({workers, kMaxLoopHelpers, chunks > 0 ? chunks - 1 : 0});
+}
+
+// Runs participant(0) on the caller and participant(1..helpers) on workers
+template<typename Participant>
+void runLoop(LoopState& state, Participant& participant, size_t helpers) {
+    std::array<LoopHelper<Participant>, kMaxLoopHelpers> items;
+    Scheduler& scheduler = Scheduler::getInstance();
+    state.setHelpers(helpers);
+    for (size_t i = 0; i < helpers; ++i) {
+        items[i].setup(&state, &participant, i + 1);
+        if (!scheduler.tryDispatch(&items[i], 0)) {
+            // The scheduler shut down; the caller takes this helper's slot
+            participant(i + 1);
+            state.helperDone();
+        }
+    }
+    participant(0);
+    state.wait();
+}
+
+} // namespace detail
+
+// Calls body(begin, end) on disjoint chunks covering range, in parallel on
+// the scheduler workers. Chunks are at least `grain` long (except the last)
+// and shrink as the loop drains. The caller takes part and, while waiting,
+// runs other queued work, so nesting inside tasks and loops is safe. Nothing
+// is heap allocated; the first exception thrown by body is rethrown.
+template<typename Body>
+void parallel_for(Range range, size_t grain, Body&& body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t helpers = detail::loopHelpers((range.size() + grain - 1) / grain);
+    if (helpers == 0) {
+        if (range.size() > 0) {
+            body(range.begin, range.end);
+        }
+        return;
+    }
+
+    detail::LoopState state(range, grain, helpers + 1);
+    auto participant = [&state, &body](size_t) {
+        Range chunk;
+        while (state.claim(chunk)) {
+            try {
+                body(chunk.begin, chunk.end);
+            } catch (...) {
+                state.fail(std::current_exception());
+            }
+        }
+    };
+    detail::runLoop(state, participant, helpers);
+}
+
+// Folds range into one value: each participant starts from identity and
+// calls partial = body(begin, end, partial) for its chunks; the partials are
+// merged with combine, which must be associative. Merge order varies between
+// runs, so floating point results may differ in the last bits.
+template<typename T, typename Body, typename Combine>
+T parallel_reduce(Range range, size_t grain, T identity, Body&& body, Combine&& combine) {
+    grain = std::max<size_t>(grain, 1);
+    size_t helpers = detail::loopHelpers((range.size() + grain - 1) / grain);
+    if (helpers == 0) {
+        return range.size() > 0 ? body(range.begin, range.end, std::move(identity)) : identity;
+    }
+
+    std::array<std::optional<T>, kMaxLoopHelpers + 1> partials;
+    detail::LoopState state(range, grain, helpers + 1);
+    auto participant = [&](size_t slot) {
+        Range chunk;
+        T partial = identity;
+        bool claimed = false;
+        while (state.claim(chunk)) {
+            try {
+                partial = body(chunk.begin, chunk.end, std::move(partial));
+                claimed = true;
+            } catch (...) {
+                state.fail(std::current_exception());
+            }
+        }
+        if (claimed) {
+            partials[slot].emplace(std::move(partial));
+        }
+    };
+    detail::runLoop(state, participant, helpers);
+
+    T result = std::move(identity);
+    for (size_t slot = 0; slot <= helpers; ++slot) {
+        if (partials[slot]) {
+            result = combine(std::move(result), std::move(*partials[slot]));
+        }
+    }
+    return result;
+}
+
+} // namespace runtime
+} // namespace uta
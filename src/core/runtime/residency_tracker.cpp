@@ -0,0 +1,83 @@
+#include "residency_tracker.hpp"
+#include <cstdint>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+// Fibonacci hashing of the cache line index. The multiply carries every
+// address bit into the top bits, so page- and huge-page-aligned buffers,
+// whose low line bits are all zero, still spread over all shards.
+size_t shardIndex(const void* buffer) {
+    constexpr unsigned kShardBits = 4;
+    static_assert(ResidencyTracker::kNumShards == size_t(1) << kShardBits,
+                  "shard count must match the hash width");
+    uint64_t line = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(buffer)) >> 6;
+    return static_cast<size_t>((line * 0x9E3779B97F4A7C15ull) >> (64 - kShardBits));
+}
+
+} // namespace
+
+ResidencyTracker& ResidencyTracker::getInstance() {
+    static ResidencyTracker instance;
+    return instance;
+}
+
+void ResidencyTracker::recordWrite(const void* buffer, size_t worker, int node) {
+    Shard& shard = shardOf(buffer);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(buffer);
+    if (it != shard.entries.end()) {
+        it->second = Residency{worker, node};
+        return;
+    }
+    if (shard.entries.size() >= kMaxEntriesPerShard) {
+        shard.entries.erase(shard.entries.begin());
+    }
+    shard.entries.emplace(buffer, Residency{worker, node});
+}
+
+bool ResidencyTracker::lookup(const void* buffer, Residency& residency) const {
+    const Shard& shard = shardOf(buffer);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(buffer);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    residency = it->second;
+    return true;
+}
+
+void ResidencyTracker::forget(const void* buffer) {
+    Shard& shard = shardOf(buffer);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(buffer);
+}
+
+void ResidencyTracker::clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+size_t ResidencyTracker::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+ResidencyTracker::Shard& ResidencyTracker::shardOf(const void* buffer) {
+    return shards_[shardIndex(buffer)];
+}
+
+const ResidencyTracker::Shard& ResidencyTracker::shardOf(const void* buffer) const {
+    return shards_[shardIndex(buffer)];
+}
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace uta {
+namespace runtime {
+
+// Where data buffers were last written
+//
+// The scheduler records the worker and NUMA node of every task output it
+// runs; placement then sends tasks to the worker whose cache likely still
+// holds their inputs. Entries are hints: a freed buffer whose address is
+// reused only misplaces a task once. Each shard keeps at most
+// kMaxEntriesPerShard buffers and drops an arbitrary entry when full.
+class ResidencyTracker {
+public:
+    static constexpr size_t kNumShards = 16;
+    static constexpr size_t kMaxEntriesPerShard = 4096;
+
+    struct Residency {
+        size_t worker;
+        int node;
+    };
+
+    static ResidencyTracker& getInstance();
+
+    void recordWrite(const void* buffer, size_t worker, int node);
+
+    // false if the buffer has no recorded writer
+    bool lookup(const void* buffer, Residency& residency) const;
+
+    // Drop a buffer, e.g. before its memory is freed
+    void forget(const void* buffer);
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<const void*, Residency> entries;
+    };
+
+    Shard& shardOf(const void* buffer);
+    const Shard& shardOf(const void* buffer) const;
+
+    Shard shards_[kNumShards];
+};
+
+} // namespace runtime
+} // namespace uta
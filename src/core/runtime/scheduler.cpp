@@ -0,0 +1,1026 @@
+#include "scheduler.hpp"
+#include "task.hpp"
+#include "executable_graph.hpp"
+#include "residency_tracker.hpp"
+#include <uta/uta.hpp>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+thread_local Scheduler* t_scheduler = nullptr;
+thread_local size_t t_worker_index = Scheduler::kNotAWorker;
+thread_local Scheduler* t_draining = nullptr;     // shutdown() running leftover work
+thread_local Scheduler* t_guarded = nullptr;      // outermost admitted DispatchGuard
+
+constexpr auto kNoDeadline = std::chrono::steady_clock::time_point::max();
+
+uint64_t toNanoseconds(std::chrono::duration<double> duration) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+// CPU pauses between two polls while spinning
+constexpr int kPausesPerPoll = 16;
+
+int64_t steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Sleeps while word == expected; spurious returns are fine for callers
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            nullptr, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>& word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count,
+            nullptr, nullptr, 0);
+}
+
+Scheduler::LatencySummary summarize(const LatencyHistogram::Snapshot& snapshot) {
+    return Scheduler::LatencySummary{
+        static_cast<size_t>(snapshot.count),
+        snapshot.percentile(0.5) * 1e-9,
+        snapshot.percentile(0.99) * 1e-9,
+        snapshot.percentile(0.999) * 1e-9,
+    };
+}
+
+} // namespace
+
+// Queue entry for a submitted Task
+class TaskItem : public WorkItem {
+public:
+    TaskItem(Scheduler& scheduler, std::shared_ptr<Task> task)
+        : scheduler_(scheduler)
+        , task_(std::move(task))
+    {}
+
+    void run(ExecutionContext& context) override {
+        std::unique_ptr<TaskItem> self(this);
+        // failures reach the caller through the task's own future
+        scheduler_.executeTask(task_, context);
+    }
+
+    Task* getTask() override { return task_.get(); }
+
+private:
+    Scheduler& scheduler_;
+    std::shared_ptr<Task> task_;
+};
+
+// Task graph
+
+size_t TaskGraph::indexOf(const std::shared_ptr<Task>& task) {
+    if (!task) {
+        throw std::invalid_argument("Task graph nodes must not be null");
+    }
+    auto it = index_.find(task.get());
+    if (it != index_.end()) {
+        return it->second;
+    }
+    size_t index = nodes_.size();
+    nodes_.push_back(Node{task, {}, 0});
+    index_.emplace(task.get(), index);
+    return index;
+}
+
+void TaskGraph::addTask(std::shared_ptr<Task> task) {
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+    indexOf(task);
+}
+
+void TaskGraph::addDependency(std::shared_ptr<Task> dependent, std::shared_ptr<Task> dependency) {
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+    size_t to = indexOf(dependent);
+    size_t from = indexOf(dependency);
+    nodes_[from].successors.push_back(to);
+    nodes_[to].num_dependencies++;
+}
+
+size_t TaskGraph::size() const {
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+    return nodes_.size();
+}
+
+// Scheduling policies
+
+size_t PriorityScheduler::selectTier(const Task& task) {
+    return static_cast<size_t>(task.getPriority());
+}
+
+void PriorityScheduler::onTaskComplete(std::shared_ptr<Task>) {
+}
+
+size_t FairScheduler::selectTier(const Task& task) {
+    size_t tier = static_cast<size_t>(task.getPriority());
+    std::lock_guard<std::mutex> lock(counts_mutex_);
+    size_t kinds = std::max<size_t>(task_counts_.size(), 1);
+    auto it = task_counts_.find(task.getName());
+    if (it != task_counts_.end() && it->second * kinds > 2 * total_count_) {
+        tier = std::min(tier + 1, numTiers() - 1);
+    }
+    return tier;
+}
+
+void FairScheduler::onTaskComplete(std::shared_ptr<Task> task) {
+    std::lock_guard<std::mutex> lock(counts_mutex_);
+    task_counts_[task->getName()]++;
+    total_count_++;
+}
+
+// Scheduler
+
+Scheduler& Scheduler::getInstance() {
+    static Scheduler instance;
+    return instance;
+}
+
+Scheduler::~Scheduler() {
+    shutdown();
+}
+
+void Scheduler::initialize(size_t num_threads, AffinityPolicy affinity) {
+    if (running_.load()) {
+        throw std::runtime_error("Scheduler is already running");
+    }
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (!scheduling_policy_) {
+        std::lock_guard<std::mutex> lock(policy_mutex_);
+        scheduling_policy_ = std::make_unique<PriorityScheduler>();
+        policy_generation_++;
+    }
+    num_tiers_ = std::max<size_t>(scheduling_policy_->numTiers(), 1);
+    policy_orders_work_ = scheduling_policy_->ordersWork();
+
+    injectors_.clear();
+    for (size_t tier = 0; tier < num_tiers_; ++tier) {
+        injectors_.push_back(std::make_unique<Injector>());
+    }
+
+    while (latency_tables_.size() < num_threads) {
+        latency_tables_.push_back(std::make_unique<TaskLatencyTable>());
+    }
+
+    auto placements = CpuTopology::getInstance().assign(affinity, num_threads);
+    workers_.clear();
+    node_workers_.clear();
+    for (size_t i = 0; i < num_threads; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->index = i;
+        worker->node = placements[i].node;
+        worker->cpus = std::move(placements[i].cpus);
+        if (worker->node >= 0) {
+            node_workers_[worker->node].push_back(i);
+        }
+        for (size_t tier = 0; tier < num_tiers_; ++tier) {
+            worker->tiers.push_back(std::make_unique<WorkStealingDeque<WorkItem*>>());
+        }
+        worker->mailboxes.reset(new std::atomic<WorkItem*>[num_tiers_]);
+        for (size_t tier = 0; tier < num_tiers_; ++tier) {
+            worker->mailboxes[tier].store(nullptr, std::memory_order_relaxed);
+        }
+        worker->context = std::make_unique<ExecutionContext>();
+        worker->context->worker_index_ = i;
+        worker->rng.seed(static_cast<std::minstd_rand::result_type>(i + 1));
+        workers_.push_back(std::move(worker));
+    }
+
+    active_workers_.store(num_threads, std::memory_order_relaxed);
+    running_.store(true);
+    for (auto& worker : workers_) {
+        Worker* self = worker.get();
+        worker->thread = std::thread([this, self] { workerThread(*self); });
+    }
+    if (pool_config_.adaptive) {
+        pool_controller_ = std::thread([this] { controlPool(); });
+    }
+}
+
+void Scheduler::shutdown() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    // Submissions that saw the scheduler running finish queuing first; the
+    // seq_cst exchange and load pair with the ones in DispatchGuard
+    while (external_dispatches_.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (pool_controller_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(controller_mutex_);
+        }
+        controller_condition_.notify_all();
+        pool_controller_.join();
+    }
+    // Parked and retired workers wake up to drain
+    wake_requested_.store(0, std::memory_order_relaxed);
+    idle_epoch_.fetch_add(1, std::memory_order_release);
+    futexWake(idle_epoch_, INT_MAX);
+    pool_epoch_.fetch_add(1, std::memory_order_release);
+    futexWake(pool_epoch_, INT_MAX);
+    // Workers drain all queued work before they exit
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // Late submissions that raced with shutdown run here; finishing one may
+    // admit a task waiting for memory into an already drained tier
+    ExecutionContext context;
+    t_draining = this;
+    for (bool drained = false; !drained; ) {
+        drained = true;
+        while (WorkItem* item = dequeuePolicyWork(kNoDeadline)) {
+            item->run(context);
+            drained = false;
+        }
+        for (size_t tier = 0; tier < num_tiers_; ++tier) {
+            while (WorkItem* item = popInjector(tier)) {
+                item->run(context);
+                drained = false;
+            }
+            for (auto& worker : workers_) {
+                WorkItem* item = worker->mailboxes[tier].exchange(nullptr);
+                while (item != nullptr) {
+                    WorkItem* next = item->next_;
+                    item->run(context);
+                    item = next;
+                    drained = false;
+                }
+            }
+        }
+    }
+    t_draining = nullptr;
+    workers_.clear();
+    active_workers_.store(0, std::memory_order_relaxed);
+}
+
+// Workers, the draining thread and threads already inside an admitted guard
+// are done before the queues go away, so only the outermost guard counts
+Scheduler::DispatchGuard::DispatchGuard(Scheduler& scheduler)
+    : scheduler_(scheduler)
+    , external_(t_scheduler != &scheduler && t_draining != &scheduler &&
+                t_guarded != &scheduler)
+{
+    if (!external_) {
+        return;
+    }
+    scheduler_.external_dispatches_.fetch_add(1);
+    if (!scheduler_.running_.load()) {
+        scheduler_.external_dispatches_.fetch_sub(1, std::memory_order_release);
+        throw std::runtime_error("Scheduler is not running");
+    }
+    t_guarded = &scheduler;
+}
+
+Scheduler::DispatchGuard::DispatchGuard(Scheduler& scheduler, std::nothrow_t)
+    : scheduler_(scheduler)
+    , external_(t_scheduler != &scheduler && t_draining != &scheduler &&
+                t_guarded != &scheduler)
+{
+    if (!external_) {
+        return;
+    }
+    scheduler_.external_dispatches_.fetch_add(1);
+    if (!scheduler_.running_.load()) {
+        scheduler_.external_dispatches_.fetch_sub(1, std::memory_order_release);
+        external_ = false;
+        admitted_ = false;
+        return;
+    }
+    t_guarded = &scheduler;
+}
+
+Scheduler::DispatchGuard::~DispatchGuard() {
+    if (external_) {
+        t_guarded = nullptr;
+        scheduler_.external_dispatches_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void Scheduler::submit(std::shared_ptr<Task> task) {
+    DispatchGuard guard(*this);
+    size_t tier = scheduling_policy_->selectTier(*task);
+    size_t worker = placeTask(*task);
+    task->markEnqueued();
+    Task& queued = *task;
+    auto item = std::make_unique<TaskItem>(*this, std::move(task));
+    dispatchTask(item.get(), queued, tier, worker);
+    // Owned by the queues, or by admission until memory frees up
+    item.release();
+}
+
+std::future<void> Scheduler::submitTaskGraph(const TaskGraph& graph) {
+    DispatchGuard guard(*this);
+    return ExecutableGraph::capture(*this, graph)->launch();
+}
+
+void Scheduler::dispatch(WorkItem* item, size_t tier) {
+    tier = clampTier(tier);
+    if (t_scheduler == this) {
+        workers_[t_worker_index]->tiers[tier]->push(item);
+        wakeWorker();
+        return;
+    }
+    DispatchGuard guard(*this);
+    pushInjector(item, tier);
+    wakeWorker();
+}
+
+bool Scheduler::tryDispatch(WorkItem* item, size_t tier) {
+    if (t_scheduler == this) {
+        dispatch(item, tier);
+        return true;
+    }
+    DispatchGuard guard(*this, std::nothrow);
+    if (!guard.admitted()) {
+        return false;
+    }
+    pushInjector(item, clampTier(tier));
+    wakeWorker();
+    return true;
+}
+
+bool Scheduler::tryDispatch(WorkItem* item, size_t tier, size_t worker) {
+    if (t_scheduler == this) {
+        dispatch(item, tier, worker);
+        return true;
+    }
+    DispatchGuard guard(*this, std::nothrow);
+    if (!guard.admitted()) {
+        return false;
+    }
+    pushMailbox(item, clampTier(tier), worker % workers_.size());
+    wakeWorker();
+    return true;
+}
+
+void Scheduler::pushInjector(WorkItem* item, size_t tier) {
+    Injector& injector = *injectors_[tier];
+    std::lock_guard<std::mutex> lock(injector.mutex);
+    injector.items.push_back(item);
+    injector.size.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Scheduler::dispatch(WorkItem* item, size_t tier, size_t worker) {
+    tier = clampTier(tier);
+    if (t_scheduler != this) {
+        DispatchGuard guard(*this);
+        pushMailbox(item, tier, worker % workers_.size());
+        wakeWorker();
+        return;
+    }
+    worker %= workers_.size();
+    if (t_worker_index == worker) {
+        workers_[worker]->tiers[tier]->push(item);
+    } else {
+        pushMailbox(item, tier, worker);
+    }
+    wakeWorker();
+}
+
+void Scheduler::pushMailbox(WorkItem* item, size_t tier, size_t worker) {
+    // Lock-free push; the owner moves the whole list onto its deque
+    std::atomic<WorkItem*>& mailbox = workers_[worker]->mailboxes[tier];
+    WorkItem* head = mailbox.load(std::memory_order_relaxed);
+    do {
+        item->next_ = head;
+    } while (!mailbox.compare_exchange_weak(head, item, std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+void Scheduler::dispatchTask(WorkItem* item, const Task& task, size_t tier, size_t worker) {
+    if (admission_.enabled()) {
+        auto compute = dynamic_cast<const ComputeTask*>(&task);
+        if (compute != nullptr &&
+            !admission_.admit(compute->getDeviceId(),
+                              {item, tier, worker, compute->getMemoryRequirement()})) {
+            // Queued by releaseMemory() once enough memory is free
+            return;
+        }
+        try {
+            enqueue(item, tier, worker);
+        } catch (...) {
+            releaseMemory(task);
+            throw;
+        }
+        return;
+    }
+    enqueue(item, tier, worker);
+}
+
+void Scheduler::enqueue(WorkItem* item, size_t tier, size_t worker) {
+    DispatchGuard guard(*this);
+    if (policy_orders_work_ && scheduling_policy_->enqueue(item)) {
+        wakeWorker();
+        return;
+    }
+    if (worker != kNotAWorker) {
+        dispatch(item, tier, worker);
+    } else {
+        dispatch(item, tier);
+    }
+}
+
+void Scheduler::releaseMemory(const Task& task) {
+    if (!admission_.enabled()) {
+        return;
+    }
+    auto compute = dynamic_cast<const ComputeTask*>(&task);
+    if (compute == nullptr) {
+        return;
+    }
+    std::vector<AdmissionController::Request> admitted;
+    admission_.release(compute->getDeviceId(), compute->getMemoryRequirement(), admitted);
+    for (const auto& request : admitted) {
+        enqueue(request.item, request.tier, request.worker);
+    }
+}
+
+void Scheduler::setMemoryLimit(int device_id, size_t bytes) {
+    if (running_.load()) {
+        throw std::runtime_error("Memory limits cannot change while the scheduler is running");
+    }
+    admission_.setLimit(device_id, bytes);
+}
+
+AdmissionController::AdmissionStats Scheduler::getAdmissionStats(int device_id) const {
+    return admission_.getStats(device_id);
+}
+
+void Scheduler::setPlacementPolicy(PlacementPolicy policy) {
+    if (running_.load()) {
+        throw std::runtime_error("Placement policy cannot change while the scheduler is running");
+    }
+    placement_ = policy;
+}
+
+void Scheduler::setPoolConfig(const PoolConfig& config) {
+    if (running_.load()) {
+        throw std::runtime_error("Pool configuration cannot change while the scheduler is running");
+    }
+    if (config.min_workers == 0 || config.control_interval.count() <= 0 ||
+        config.shrink_utilization > config.grow_utilization) {
+        throw std::invalid_argument("Invalid worker pool configuration");
+    }
+    pool_config_ = config;
+}
+
+void Scheduler::setSchedulingPolicy(std::unique_ptr<SchedulingPolicy> policy) {
+    if (running_.load()) {
+        throw std::runtime_error("Scheduling policy cannot change while the scheduler is running");
+    }
+    // The old policy drops the ranks of graphs it prepared with it
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    scheduling_policy_ = std::move(policy);
+    policy_generation_++;
+}
+
+bool Scheduler::runPendingWork() {
+    if (t_scheduler != this) {
+        return false;
+    }
+    Worker& worker = *workers_[t_worker_index];
+    WorkItem* item = findWork(worker);
+    if (item == nullptr) {
+        return false;
+    }
+    item->run(*worker.context);
+    return true;
+}
+
+bool Scheduler::preemptionPoint() {
+    if (t_scheduler != this || !policy_orders_work_) {
+        return false;
+    }
+    ExecutionContext& context = *workers_[t_worker_index]->context;
+    auto deadline = context.current_task_ != nullptr ? context.current_task_->getDeadline()
+                                                     : kNoDeadline;
+    bool ran = false;
+    while (WorkItem* item = dequeuePolicyWork(deadline)) {
+        item->run(context);
+        ran = true;
+    }
+    return ran;
+}
+
+WorkItem* Scheduler::dequeuePolicyWork(std::chrono::steady_clock::time_point before) {
+    if (!policy_orders_work_ || !scheduling_policy_->hasWork()) {
+        return nullptr;
+    }
+    return scheduling_policy_->dequeue(before);
+}
+
+size_t Scheduler::currentWorker() {
+    return t_worker_index;
+}
+
+Scheduler::PerformanceMetrics Scheduler::getMetrics() const {
+    PerformanceMetrics result{};
+    result.tasks_completed = metrics_.completed_tasks.load(std::memory_order_relaxed);
+    result.tasks_failed = metrics_.failed_tasks.load(std::memory_order_relaxed);
+    result.tasks_cancelled = metrics_.cancelled_tasks.load(std::memory_order_relaxed);
+    result.tasks_stolen = metrics_.stolen_tasks.load(std::memory_order_relaxed);
+    result.warm_placements = metrics_.warm_placements.load(std::memory_order_relaxed);
+    result.deadline_tasks = metrics_.deadline_tasks.load(std::memory_order_relaxed);
+    result.deadline_misses = metrics_.deadline_misses.load(std::memory_order_relaxed);
+
+    std::unordered_map<std::string, TaskLatencyTable::TaskSnapshot> snapshots;
+    for (const auto& table : latency_tables_) {
+        table->addTo(snapshots);
+    }
+    external_latency_.addTo(snapshots);
+
+    LatencyHistogram::Snapshot wait_time;
+    LatencyHistogram::Snapshot execution_time;
+    for (const auto& entry : snapshots) {
+        const TaskLatencyTable::TaskSnapshot& snapshot = entry.second;
+        result.tasks[entry.first] = TaskLatency{summarize(snapshot.wait_time),
+                                                summarize(snapshot.execution_time)};
+        wait_time.add(snapshot.wait_time);
+        execution_time.add(snapshot.execution_time);
+    }
+    result.wait_time = summarize(wait_time);
+    result.execution_time = summarize(execution_time);
+    result.average_wait_time = wait_time.mean() * 1e-9;
+    result.average_execution_time = execution_time.mean() * 1e-9;
+
+    result.active_workers = active_workers_.load(std::memory_order_relaxed);
+    result.worker_wakeups = metrics_.wakeups.load(std::memory_order_relaxed);
+    result.idle_spin_time = metrics_.spin_ns.load(std::memory_order_relaxed) * 1e-9;
+    result.idle_park_time = metrics_.parked_ns.load(std::memory_order_relaxed) * 1e-9;
+    LatencyHistogram::Snapshot wakeup_latency;
+    wakeup_latency_.addTo(wakeup_latency);
+    result.wakeup_latency = summarize(wakeup_latency);
+    return result;
+}
+
+std::shared_ptr<Task> Scheduler::makeTask(std::function<void(ExecutionContext&)> function) {
+    return std::make_shared<Task>("anonymous", std::move(function));
+}
+
+void Scheduler::workerThread(Worker& worker) {
+    t_scheduler = this;
+    t_worker_index = worker.index;
+
+    if (!worker.cpus.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : worker.cpus) {
+            CPU_SET(cpu, &cpus);
+        }
+        // Best effort, a restricted cpuset leaves the thread unpinned
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    for (;;) {
+        if (WorkItem* item = findWork(worker)) {
+            item->run(*worker.context);
+            continue;
+        }
+        if (!running_.load(std::memory_order_acquire)) {
+            break;
+        }
+        idle(worker);
+    }
+
+    t_scheduler = nullptr;
+    t_worker_index = kNotAWorker;
+}
+
+WorkItem* Scheduler::findWork(Worker& worker) {
+    // Work the policy orders itself, e.g. by deadline, goes first
+    WorkItem* item = dequeuePolicyWork(kNoDeadline);
+    if (item != nullptr) {
+        return item;
+    }
+    // Own deques and the injector first, most urgent tier first
+    for (size_t tier = 0; tier < num_tiers_; ++tier) {
+        if (worker.tiers[tier]->pop(item)) {
+            return item;
+        }
+        if ((item = takeMailbox(worker, worker, tier)) != nullptr) {
+            return item;
+        }
+        if ((item = popInjector(tier)) != nullptr) {
+            return item;
+        }
+    }
+    for (size_t tier = 0; tier < num_tiers_; ++tier) {
+        if ((item = steal(worker, tier)) != nullptr) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+WorkItem* Scheduler::popInjector(size_t tier) {
+    Injector& injector = *injectors_[tier];
+    if (injector.size.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(injector.mutex);
+    if (injector.items.empty()) {
+        return nullptr;
+    }
+    WorkItem* item = injector.items.front();
+    injector.items.pop_front();
+    injector.size.fetch_sub(1, std::memory_order_relaxed);
+    return item;
+}
+
+WorkItem* Scheduler::steal(Worker& thief, size_t tier) {
+    size_t count = workers_.size();
+    if (count < 2) {
+        return nullptr;
+    }
+    // Random start spreads thieves over victims; same-node victims go first
+    size_t start = thief.rng() % count;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < count; ++i) {
+            Worker& victim = *workers_[(start + i) % count];
+            if (&victim == &thief || (victim.node == thief.node) != (pass == 0)) {
+                continue;
+            }
+            if (WorkItem* item = stealFrom(thief, victim, tier)) {
+                metrics_.stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+                return item;
+            }
+        }
+    }
+    return nullptr;
+}
+
+WorkItem* Scheduler::stealFrom(Worker& thief, Worker& victim, size_t tier) {
+    WorkItem* item = nullptr;
+    if (victim.tiers[tier]->steal(item)) {
+        return item;
+    }
+    return takeMailbox(victim, thief, tier);
+}
+
+WorkItem* Scheduler::takeMailbox(Worker& owner, Worker& taker, size_t tier) {
+    std::atomic<WorkItem*>& mailbox = owner.mailboxes[tier];
+    if (mailbox.load(std::memory_order_relaxed) == nullptr) {
+        return nullptr;
+    }
+    WorkItem* item = mailbox.exchange(nullptr, std::memory_order_acquire);
+    if (item == nullptr) {
+        return nullptr;
+    }
+    // Run the first item, queue the rest where they can be stolen again
+    for (WorkItem* rest = item->next_; rest != nullptr; ) {
+        WorkItem* next = rest->next_;
+        taker.tiers[tier]->push(rest);
+        rest = next;
+    }
+    return item;
+}
+
+void Scheduler::wakeWorker() {
+    // Pairs with the fence in park(): either the sleeper sees the new item or we see the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    wake_requested_.store(steadyNanoseconds(), std::memory_order_relaxed);
+    idle_epoch_.fetch_add(1, std::memory_order_release);
+    futexWake(idle_epoch_, 1);
+    metrics_.wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Scheduler::idle(Worker& worker) {
+    int64_t start = steadyNanoseconds();
+    worker.idle_since.store(start, std::memory_order_relaxed);
+
+    // Short gaps between items are cheaper to poll through than a futex round trip
+    size_t rounds = pool_config_.spin_rounds + pool_config_.yield_rounds;
+    bool found = false;
+    for (size_t round = 0; round < rounds && !found; ++round) {
+        if (round < pool_config_.spin_rounds) {
+            for (int i = 0; i < kPausesPerPoll; ++i) {
+                cpuRelax();
+            }
+        } else {
+            std::this_thread::yield();
+        }
+        found = hasWork(worker) || !running_.load(std::memory_order_relaxed);
+    }
+    int64_t parked = steadyNanoseconds();
+    metrics_.spin_ns.fetch_add(parked - start, std::memory_order_relaxed);
+
+    int64_t end = parked;
+    if (!found) {
+        if (worker.index >= active_workers_.load(std::memory_order_acquire)) {
+            retire(worker);
+        } else {
+            park(worker);
+        }
+        end = steadyNanoseconds();
+        metrics_.parked_ns.fetch_add(end - parked, std::memory_order_relaxed);
+    }
+    worker.idle_since.store(0, std::memory_order_relaxed);
+    worker.idle_ns.fetch_add(end - start, std::memory_order_relaxed);
+}
+
+bool Scheduler::hasWork(const Worker& worker) const {
+    if (policy_orders_work_ && scheduling_policy_->hasWork()) {
+        return true;
+    }
+    for (size_t tier = 0; tier < num_tiers_; ++tier) {
+        if (injectors_[tier]->size.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+        for (const auto& other : workers_) {
+            if (other->mailboxes[tier].load(std::memory_order_relaxed) != nullptr ||
+                (other.get() != &worker && !other->tiers[tier]->empty())) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Scheduler::park(Worker& worker) {
+    uint32_t epoch = idle_epoch_.load(std::memory_order_acquire);
+    sleeping_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!hasWork(worker) && running_.load(std::memory_order_relaxed)) {
+        futexWait(idle_epoch_, epoch);
+        if (idle_epoch_.load(std::memory_order_relaxed) != epoch) {
+            int64_t requested = wake_requested_.load(std::memory_order_relaxed);
+            int64_t latency = steadyNanoseconds() - requested;
+            if (requested != 0 && latency > 0) {
+                wakeup_latency_.record(static_cast<uint64_t>(latency));
+            }
+        }
+    }
+    sleeping_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Scheduler::retire(Worker& worker) {
+    // Queued items stay reachable: active workers steal from this worker's
+    // deques and mailboxes
+    uint32_t epoch = pool_epoch_.load(std::memory_order_acquire);
+    if (worker.index >= active_workers_.load(std::memory_order_acquire) &&
+        running_.load(std::memory_order_relaxed)) {
+        futexWait(pool_epoch_, epoch);
+    }
+}
+
+void Scheduler::controlPool() {
+    size_t num_workers = workers_.size();
+    std::vector<uint64_t> last_idle(num_workers, 0);
+    int64_t last_sample = steadyNanoseconds();
+
+    // Idle time so far, including an idle period still in progress
+    auto idleTime = [this](size_t index, int64_t now) {
+        const Worker& worker = *workers_[index];
+        uint64_t total = worker.idle_ns.load(std::memory_order_relaxed);
+        int64_t since = worker.idle_since.load(std::memory_order_relaxed);
+        return since != 0 && now > since ? total + static_cast<uint64_t>(now - since) : total;
+    };
+
+    std::unique_lock<std::mutex> lock(controller_mutex_);
+    while (running_.load(std::memory_order_relaxed)) {
+        controller_condition_.wait_for(lock, pool_config_.control_interval, [this] {
+            return !running_.load(std::memory_order_relaxed);
+        });
+        if (!running_.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        int64_t now = steadyNanoseconds();
+        size_t active = active_workers_.load(std::memory_order_relaxed);
+        uint64_t idle_ns = 0;
+        for (size_t i = 0; i < num_workers; ++i) {
+            uint64_t idle = idleTime(i, now);
+            if (i < active) {
+                idle_ns += idle - std::min(idle, last_idle[i]);
+            }
+            last_idle[i] = idle;
+        }
+        double capacity = static_cast<double>(now - last_sample) * active;
+        double utilization = capacity > 0 ? 1.0 - std::min(1.0, idle_ns / capacity) : 0.0;
+        last_sample = now;
+
+        size_t queued = queuedItems();
+        if (active < num_workers && queued > active &&
+            utilization >= pool_config_.grow_utilization) {
+            active_workers_.store(active + 1, std::memory_order_release);
+            pool_epoch_.fetch_add(1, std::memory_order_release);
+            futexWake(pool_epoch_, INT_MAX);
+        } else if (active > pool_config_.min_workers && queued == 0 &&
+                   utilization < pool_config_.shrink_utilization) {
+            // The retired worker finishes its current item and parks when idle
+            active_workers_.store(active - 1, std::memory_order_release);
+            wake_requested_.store(0, std::memory_order_relaxed);
+            idle_epoch_.fetch_add(1, std::memory_order_release);
+            futexWake(idle_epoch_, INT_MAX);
+        }
+    }
+}
+
+size_t Scheduler::queuedItems() const {
+    size_t queued = 0;
+    for (size_t tier = 0; tier < num_tiers_; ++tier) {
+        queued += injectors_[tier]->size.load(std::memory_order_relaxed);
+        for (const auto& worker : workers_) {
+            queued += worker->tiers[tier]->size();
+            queued += worker->mailboxes[tier].load(std::memory_order_relaxed) != nullptr;
+        }
+    }
+    if (policy_orders_work_ && scheduling_policy_->hasWork()) {
+        queued++;
+    }
+    return queued;
+}
+
+std::exception_ptr Scheduler::executeTask(const std::shared_ptr<Task>& task,
+                                          ExecutionContext& context) {
+    auto start = std::chrono::steady_clock::now();
+    if (task->isCancelled()) {
+        metrics_.cancelled_tasks.fetch_add(1, std::memory_order_relaxed);
+        releaseMemory(*task);
+        return nullptr;
+    }
+    std::exception_ptr error;
+    const Task* outer_task = context.current_task_;
+    context.current_task_ = task.get();
+    try {
+        // Device tensors the task touches stay pinned until it returns
+        TensorScope tensor_scope;
+        task->execute(context);
+        auto& counter = task->getStatus() == TaskStatus::CANCELLED ? metrics_.cancelled_tasks
+                                                                    : metrics_.completed_tasks;
+        counter.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        error = std::current_exception();
+        metrics_.failed_tasks.fetch_add(1, std::memory_order_relaxed);
+    }
+    context.current_task_ = outer_task;
+    if (task->hasDeadline()) {
+        metrics_.deadline_tasks.fetch_add(1, std::memory_order_relaxed);
+        if (std::chrono::steady_clock::now() > task->getDeadline()) {
+            metrics_.deadline_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    releaseMemory(*task);
+    if (!error && task->getStatus() == TaskStatus::COMPLETED) {
+        recordOutputs(*task);
+    }
+    TaskLatencyTable& latency = t_scheduler == this ? *latency_tables_[t_worker_index]
+                                                    : external_latency_;
+    latency.record(task->getName(), toNanoseconds(task->getWaitTime()),
+                   toNanoseconds(std::chrono::steady_clock::now() - start));
+    scheduling_policy_->onTaskComplete(task);
+    return error;
+}
+
+size_t Scheduler::clampTier(size_t tier) const {
+    return std::min(tier, num_tiers_ - 1);
+}
+
+size_t Scheduler::selectWorker(int node) {
+    if (node < 0) {
+        return kNotAWorker;
+    }
+    auto it = node_workers_.find(node);
+    if (it == node_workers_.end()) {
+        return kNotAWorker;
+    }
+    const auto& workers = it->second;
+    return workers[next_node_worker_.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+}
+
+size_t Scheduler::placeTask(const Task& task) {
+    const auto& inputs = task.getInputs();
+    if (placement_ != PlacementPolicy::DATA_LOCALITY || inputs.empty()) {
+        return selectWorker(task.getLocalityHint());
+    }
+
+    // Inputs are few; a linear tally beats a map
+    struct Tally {
+        size_t worker;
+        int node;
+        size_t bytes;
+    };
+    std::vector<Tally> tallies;
+    ResidencyTracker& residency = ResidencyTracker::getInstance();
+    for (const auto& input : inputs) {
+        ResidencyTracker::Residency where;
+        if (!residency.lookup(input.buffer, where) || where.worker >= workers_.size()) {
+            continue;
+        }
+        auto it = std::find_if(tallies.begin(), tallies.end(),
+                               [&](const Tally& tally) { return tally.worker == where.worker; });
+        if (it == tallies.end()) {
+            tallies.push_back(Tally{where.worker, where.node, input.bytes});
+        } else {
+            it->bytes += input.bytes;
+        }
+    }
+    if (tallies.empty()) {
+        return selectWorker(task.getLocalityHint());
+    }
+    const Tally& warm = *std::max_element(tallies.begin(), tallies.end(),
+        [](const Tally& a, const Tally& b) { return a.bytes < b.bytes; });
+
+    // A retired worker would leave the task to thieves; prefer its node then
+    if (warm.worker < active_workers_.load(std::memory_order_relaxed)) {
+        metrics_.warm_placements.fetch_add(1, std::memory_order_relaxed);
+        return warm.worker;
+    }
+    size_t worker = selectWorker(warm.node);
+    return worker != kNotAWorker ? worker : selectWorker(task.getLocalityHint());
+}
+
+void Scheduler::recordOutputs(const Task& task) {
+    if (placement_ != PlacementPolicy::DATA_LOCALITY || t_scheduler != this) {
+        return;
+    }
+    const auto& outputs = task.getOutputs();
+    if (outputs.empty()) {
+        return;
+    }
+    size_t worker = t_worker_index;
+    int node = workers_[worker]->node;
+    ResidencyTracker& residency = ResidencyTracker::getInstance();
+    for (const auto& output : outputs) {
+        residency.recordWrite(output.buffer, worker, node);
+    }
+}
+
+// Execution context
+
+ExecutionContext::~ExecutionContext() {
+    for (auto& allocation : allocations_) {
+        std::free(allocation.first);
+    }
+}
+
+void* ExecutionContext::allocateMemory(size_t size) {
+    void* ptr = std::malloc(std::max<size_t>(size, 1));
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    allocations_[ptr] = size;
+    return ptr;
+}
+
+void ExecutionContext::freeMemory(void* ptr) {
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    if (allocations_.erase(ptr) == 0) {
+        throw std::invalid_argument("Pointer was not allocated by this execution context");
+    }
+    std::free(ptr);
+}
+
+void ExecutionContext::setDevice(int device_id) {
+    current_device_ = device_id;
+}
+
+void ExecutionContext::synchronize() {
+    // host work runs synchronously on the worker
+}
+
+CancellationToken ExecutionContext::getCancellationToken() const {
+    return current_task_ != nullptr ? current_task_->getCancellationToken()
+                                    : CancellationToken::none();
+}
+
+bool ExecutionContext::isCancelled() const {
+    return current_task_ != nullptr && current_task_->isCancelled();
+}
+
+} // namespace runtime
+} // namespace uta
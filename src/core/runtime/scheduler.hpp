@@ -1,21 +1,33 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
-#include <queue>
+#include <deque>
+#include <exception>
 #include <vector>
 #include <functional>
 #include <future>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <new>
 #include <condition_variable>
+#include <type_traits>
 #include <unordered_map>
+#include "admission_controller.hpp"
+#include "latency_histogram.hpp"
+#include "topology.hpp"
+#include "work_stealing_deque.hpp"
 
 namespace uta {
 namespace runtime {
 
 // forward statement
 class Task;
-class TaskQueue;
 class ExecutionContext;
 
 // task priority
@@ -35,46 +47,136 @@ enum class TaskStatus {
     CANCELLED
 };
 
+// Cancellation flag shared by a task and the code it runs
+//
+// Copies share one flag. Long kernels poll isCancelled() between iterations
+// and return early; polling is one relaxed load.
+class CancellationToken {
+public:
+    CancellationToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    // A token that is never cancelled
+    static CancellationToken none() { return CancellationToken(nullptr); }
+
+    void cancel() {
+        if (flag_) {
+            flag_->store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool isCancelled() const { return flag_ && flag_->load(std::memory_order_relaxed); }
+
+private:
+    explicit CancellationToken(std::nullptr_t) {}
+
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+// one tier per TaskPriority by default
+constexpr size_t kNumPriorityTiers = 4;
+
+// where submitted tasks are queued first; idle workers may steal them either way
+enum class PlacementPolicy {
+    LOCALITY_HINT,  // the task's NUMA locality hint, else the submitting worker
+    DATA_LOCALITY   // the worker that last wrote most of the task's input bytes,
+                    // else that worker's node, else the locality hint
+};
+
+// Unit of work in the worker queues
+class WorkItem {
+public:
+    virtual ~WorkItem() = default;
+
+    // Runs on a worker thread; the item may be destroyed before run() returns
+    virtual void run(ExecutionContext& context) = 0;
+
+    // Task carried by this item, if any
+    virtual Task* getTask() { return nullptr; }
+
+private:
+    WorkItem* next_{nullptr};    // worker mailbox link
+
+    friend class Scheduler;
+};
+
 // Task dependence graph
+//
+// A graph only describes tasks and edges; Scheduler::submitTaskGraph runs it.
+// Submitting takes a snapshot, so one graph can be submitted repeatedly.
 class TaskGraph {
 public:
     void addTask(std::shared_ptr<Task> task);
     void addDependency(std::shared_ptr<Task> dependent, std::shared_ptr<Task> dependency);
-    std::vector<std::shared_ptr<Task>> getReadyTasks();
-    bool hasUnfinishedTasks() const;
+    size_t size() const;
+    bool empty() const { return size() == 0; }
 
 private:
     struct Node {
         std::shared_ptr<Task> task;
-        std::vector<std::shared_ptr<Task>> dependencies;
-        std::vector<std::shared_ptr<Task>> dependents;
+        std::vector<size_t> successors;
+        size_t num_dependencies{0};
     };
-    std::unordered_map<std::shared_ptr<Task>, Node> graph_;
-    std::mutex graph_mutex_;
+
+    size_t indexOf(const std::shared_ptr<Task>& task);
+
+    std::vector<Node> nodes_;
+    std::unordered_map<Task*, size_t> index_;
+    mutable std::mutex graph_mutex_;
+
+    friend class ExecutableGraph;
+};
+
+// Read-only view of a captured graph; node i's successors are
+// successors[successor_offsets[i] .. successor_offsets[i + 1])
+struct GraphTopology {
+    const std::vector<std::shared_ptr<Task>>& tasks;
+    const std::vector<size_t>& successor_offsets;
+    const std::vector<size_t>& successors;
 };
 
 // scheduling policy
+//
+// Workers drain tier 0 first. A policy decides which tier a ready task is
+// queued in; queueing itself is per-worker and lock-free.
 class SchedulingPolicy {
 public:
     virtual ~SchedulingPolicy() = default;
-    virtual std::shared_ptr<Task> selectNext(const TaskQueue& queue) = 0;
+    virtual size_t numTiers() const { return kNumPriorityTiers; }
+    virtual size_t selectTier(const Task& task) = 0;
     virtual void onTaskComplete(std::shared_ptr<Task> task) = 0;
+
+    // Called when a graph is captured, before selectTier for its nodes
+    virtual void prepareGraph(const GraphTopology&) {}
+
+    // Called when a captured graph is destroyed; its tasks may be freed next
+    virtual void releaseGraph(const GraphTopology&) {}
+
+    // Policies that order work themselves keep it out of the tier queues:
+    // enqueue() takes the items it wants, and workers poll dequeue() before
+    // their own deques
+    virtual bool ordersWork() const { return false; }
+    virtual bool enqueue(WorkItem*) { return false; }
+    virtual bool hasWork() const { return false; }
+
+    // Most urgent item due before the given deadline, nullptr if none
+    virtual WorkItem* dequeue(std::chrono::steady_clock::time_point) { return nullptr; }
 };
 
 // priority scheduling policy
 class PriorityScheduler : public SchedulingPolicy {
 public:
-    std::shared_ptr<Task> selectNext(const TaskQueue& queue) override;
+    size_t selectTier(const Task& task) override;
     void onTaskComplete(std::shared_ptr<Task> task) override;
 };
 
-// fair scheduling policy
+// fair scheduling policy, demotes task names that take more than twice their share
 class FairScheduler : public SchedulingPolicy {
 public:
-    std::shared_ptr<Task> selectNext(const TaskQueue& queue) override;
+    size_t selectTier(const Task& task) override;
     void onTaskComplete(std::shared_ptr<Task> task) override;
 private:
     std::unordered_map<std::string, size_t> task_counts_;
+    size_t total_count_{0};
     std::mutex counts_mutex_;
 };
 
@@ -83,89 +185,329 @@ class Scheduler {
 public:
     static Scheduler& getInstance();
 
+    static constexpr size_t kNotAWorker = static_cast<size_t>(-1);
+
     // initialization
-    void initialize(size_t num_threads);
+    void initialize(size_t num_threads, AffinityPolicy affinity = AffinityPolicy::NONE);
     void shutdown();
 
     // task submission
     template<typename F, typename... Args>
-    auto submitTask(F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type>;
+    auto submitTask(F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>>;
+
+    void submit(std::shared_ptr<Task> task);
+
+    // batch task submission; the future holds the first task failure, if any
+    std::future<void> submitTaskGraph(const TaskGraph& graph);
+
+    // Queue a work item; from a worker it lands on that worker's own deque
+    void dispatch(WorkItem* item, size_t tier);
 
-    // batch task submission
-    void submitTaskGraph(const TaskGraph& graph);
+    // Queue a work item for a preferred worker; idle workers may still take it
+    void dispatch(WorkItem* item, size_t tier, size_t worker);
 
-    // scheduling policy configuration
+    // dispatch(item, tier) that returns false instead of throwing once the
+    // scheduler has shut down, for completions arriving after shutdown
+    bool tryDispatch(WorkItem* item, size_t tier);
+    bool tryDispatch(WorkItem* item, size_t tier, size_t worker);
+
+    // scheduling policy configuration, only while the scheduler is stopped
     void setSchedulingPolicy(std::unique_ptr<SchedulingPolicy> policy);
 
-    // performance monitoring
+    // Device memory that running ComputeTasks may reserve through their
+    // memory requirement, 0 for no limit; only while the scheduler is stopped
+    void setMemoryLimit(int device_id, size_t bytes);
+    AdmissionController::AdmissionStats getAdmissionStats(int device_id) const;
+
+    // Run one queued item on the calling worker while it waits for other
+    // work; returns false when nothing was found or the caller is not a worker
+    bool runPendingWork();
+
+    // How idle workers wait and how many of them stay active
+    //
+    // An idle worker polls for work spin_rounds times with CPU pauses in
+    // between, then yield_rounds times with thread yields, then parks on a
+    // futex until new work is queued. With adaptive set, a controller thread
+    // samples utilization every control_interval: it retires the highest
+    // numbered active worker while utilization is low and nothing is queued,
+    // and brings one back while workers are busy and work is backing up.
+    struct PoolConfig {
+        size_t spin_rounds = 64;
+        size_t yield_rounds = 16;
+        bool adaptive = false;
+        size_t min_workers = 1;
+        std::chrono::milliseconds control_interval{10};
+        double grow_utilization = 0.9;
+        double shrink_utilization = 0.5;
+    };
+
+    // Only while the scheduler is stopped
+    void setPlacementPolicy(PlacementPolicy policy);
+    PlacementPolicy getPlacementPolicy() const { return placement_; }
+
+    // Only while the scheduler is stopped
+    void setPoolConfig(const PoolConfig& config);
+    PoolConfig getPoolConfig() const { return pool_config_; }
+
+    // Workers currently allowed to take work
+    size_t getActiveWorkers() const { return active_workers_.load(std::memory_order_relaxed); }
+
+    // Called by long tasks between sub-tasks: runs policy-ordered work due
+    // before the calling task's own deadline; returns false if there was none
+    bool preemptionPoint();
+
+    // worker information
+    size_t getNumWorkers() const { return workers_.size(); }
+    static size_t currentWorker();
+
+    // NUMA node a worker is pinned to, -1 if unpinned
+    int getWorkerNode(size_t worker) const { return workers_.at(worker)->node; }
+
+    // performance monitoring, times in seconds
+    struct LatencySummary {
+        size_t count;
+        double p50;
+        double p99;
+        double p999;
+    };
+
+    struct TaskLatency {
+        LatencySummary wait_time;
+        LatencySummary execution_time;
+    };
+
     struct PerformanceMetrics {
         size_t tasks_completed;
         size_t tasks_failed;
+        size_t tasks_cancelled;     // skipped, or stopped early through their token
+        size_t tasks_stolen;
+        size_t warm_placements;     // tasks queued on the last writer of their inputs
         double average_wait_time;
         double average_execution_time;
+        size_t deadline_tasks;      // finished tasks that had a deadline
+        size_t deadline_misses;     // of those, finished after it
+        LatencySummary wait_time;
+        LatencySummary execution_time;
+        std::unordered_map<std::string, TaskLatency> tasks;    // by task name
+        size_t active_workers;
+        size_t worker_wakeups;      // parked workers woken for new work
+        double idle_spin_time;      // worker time burned polling for work
+        double idle_park_time;      // worker time spent parked
+        LatencySummary wakeup_latency;     // from queueing work to a parked worker running
     };
 
     PerformanceMetrics getMetrics() const;
 
+    ~Scheduler();
+
 private:
     Scheduler() = default;
-    
+
+    // Per-worker state, cache line aligned against false sharing
+    struct alignas(64) Worker {
+        size_t index;
+        int node{-1};
+        std::vector<int> cpus;
+        std::vector<std::unique_ptr<WorkStealingDeque<WorkItem*>>> tiers;
+        std::unique_ptr<std::atomic<WorkItem*>[]> mailboxes;    // one per tier
+        std::unique_ptr<ExecutionContext> context;
+        std::minstd_rand rng;
+        std::thread thread;
+
+        // Idle time, for the pool controller
+        std::atomic<int64_t> idle_since{0};     // steady clock ns, 0 while working
+        std::atomic<uint64_t> idle_ns{0};
+    };
+
+    // Submissions from non-worker threads
+    struct alignas(64) Injector {
+        std::mutex mutex;
+        std::deque<WorkItem*> items;
+        std::atomic<size_t> size{0};
+    };
+
+    static std::shared_ptr<Task> makeTask(std::function<void(ExecutionContext&)> function);
+
     // Worker thread function
-    void workerThread();
-    
+    void workerThread(Worker& worker);
+    WorkItem* findWork(Worker& worker);
+    WorkItem* popInjector(size_t tier);
+    WorkItem* steal(Worker& thief, size_t tier);
+    WorkItem* stealFrom(Worker& thief, Worker& victim, size_t tier);
+    WorkItem* takeMailbox(Worker& owner, Worker& taker, size_t tier);
+    void wakeWorker();
+    void idle(Worker& worker);
+    bool hasWork(const Worker& worker) const;
+    void park(Worker& worker);
+    void retire(Worker& worker);
+
+    // Adaptive pool sizing
+    void controlPool();
+    size_t queuedItems() const;
+
+    // Queue a task's work item once its memory is reserved; worker may be kNotAWorker
+    void dispatchTask(WorkItem* item, const Task& task, size_t tier, size_t worker);
+    void enqueue(WorkItem* item, size_t tier, size_t worker);
+    void releaseMemory(const Task& task);
+
+    // Policy-ordered item due before the given deadline, nullptr if none
+    WorkItem* dequeuePolicyWork(std::chrono::steady_clock::time_point before);
+
     // Task execution
-    void executeTask(std::shared_ptr<Task> task);
-    
+    std::exception_ptr executeTask(const std::shared_ptr<Task>& task, ExecutionContext& context);
+
+    size_t clampTier(size_t tier) const;
+
+    // Round-robin worker on a NUMA node, kNotAWorker if none is pinned there
+    size_t selectWorker(int node);
+
+    // Preferred worker for a submitted task under placement_, may be kNotAWorker
+    size_t placeTask(const Task& task);
+
+    // Record a finished task's outputs as resident on the calling worker
+    void recordOutputs(const Task& task);
+
+    // Held by a thread outside the pool while it queues work. shutdown() waits
+    // for every holder before it drains and tears down the queues; once it
+    // has started, new holders are refused.
+    class DispatchGuard {
+    public:
+        explicit DispatchGuard(Scheduler& scheduler);
+        // Refused guards report it through admitted() instead of throwing
+        DispatchGuard(Scheduler& scheduler, std::nothrow_t);
+        ~DispatchGuard();
+
+        DispatchGuard(const DispatchGuard&) = delete;
+        DispatchGuard& operator=(const DispatchGuard&) = delete;
+
+        bool admitted() const { return admitted_; }
+
+    private:
+        Scheduler& scheduler_;
+        bool external_;
+        bool admitted_{true};
+    };
+
+    void pushMailbox(WorkItem* item, size_t tier, size_t worker);
+    void pushInjector(WorkItem* item, size_t tier);
+
     // Internal state
-    std::unique_ptr<TaskQueue> task_queue_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Injector>> injectors_;
     std::unique_ptr<SchedulingPolicy> scheduling_policy_;
-    std::vector<std::thread> worker_threads_;
+    // Captured graphs prepare and release their nodes under policy_mutex_;
+    // policy_generation_ changes whenever scheduling_policy_ is replaced
+    std::mutex policy_mutex_;
+    uint64_t policy_generation_{0};
+    bool policy_orders_work_{false};
+    size_t num_tiers_{kNumPriorityTiers};
     std::atomic<bool> running_{false};
-    
+    std::atomic<size_t> external_dispatches_{0};     // DispatchGuards outside the pool
+
+    PlacementPolicy placement_{PlacementPolicy::DATA_LOCALITY};
+
+    // workers by NUMA node, for locality hints
+    std::unordered_map<int, std::vector<size_t>> node_workers_;
+    std::atomic<size_t> next_node_worker_{0};
+
+    // idle workers; parked ones wait for idle_epoch_ to change, retired
+    // ones for pool_epoch_
+    PoolConfig pool_config_;
+    std::atomic<size_t> sleeping_{0};
+    std::atomic<uint32_t> idle_epoch_{0};
+    std::atomic<uint32_t> pool_epoch_{0};
+    std::atomic<size_t> active_workers_{0};
+    std::atomic<int64_t> wake_requested_{0};    // steady clock ns of the last wakeup
+    LatencyHistogram wakeup_latency_;
+
+    std::thread pool_controller_;
+    std::mutex controller_mutex_;
+    std::condition_variable controller_condition_;
+
+    AdmissionController admission_;
+
     // performance monitoring
     struct Metrics {
         std::atomic<size_t> completed_tasks{0};
         std::atomic<size_t> failed_tasks{0};
-        std::vector<double> wait_times;
-        std::vector<double> execution_times;
-        mutable std::mutex metrics_mutex;
+        std::atomic<size_t> cancelled_tasks{0};
+        std::atomic<size_t> stolen_tasks{0};
+        std::atomic<size_t> warm_placements{0};
+        std::atomic<size_t> deadline_tasks{0};
+        std::atomic<size_t> deadline_misses{0};
+        std::atomic<size_t> wakeups{0};
+        std::atomic<uint64_t> spin_ns{0};
+        std::atomic<uint64_t> parked_ns{0};
     };
-    
+
     Metrics metrics_;
-};
 
-// task queue
-class TaskQueue {
-public:
-    void push(std::shared_ptr<Task> task);
-    std::shared_ptr<Task> pop();
-    bool empty() const;
-    size_t size() const;
+    // Latency histograms, one table per worker index and one for other threads;
+    // kept across restarts and only grown while the scheduler is stopped
+    std::vector<std::unique_ptr<TaskLatencyTable>> latency_tables_;
+    TaskLatencyTable external_latency_;
 
-private:
-    std::priority_queue<
-        std::shared_ptr<Task>,
-        std::vector<std::shared_ptr<Task>>,
-        std::function<bool(const std::shared_ptr<Task>&, const std::shared_ptr<Task>&)>
-    > queue_;
-    mutable std::mutex queue_mutex_;
-    std::condition_variable condition_;
+    friend class TaskItem;
+    friend class TaskBatch;
+    friend class ExecutableGraph;
+    friend class CopyEngine;
 };
 
 // execution context
 class ExecutionContext {
 public:
+    ~ExecutionContext();
+
     void* allocateMemory(size_t size);
     void freeMemory(void* ptr);
     void setDevice(int device_id);
+    int getDevice() const { return current_device_; }
+    size_t getWorkerIndex() const { return worker_index_; }
     void synchronize();
 
+    // Cancellation state of the running task; none() outside of a task
+    CancellationToken getCancellationToken() const;
+    bool isCancelled() const;
+
+    // Scratch memory planned for the running graph node, if any
+    void* getScratch() const { return scratch_; }
+    size_t getScratchSize() const { return scratch_size_; }
+
+    // Argument bound to an ExecutableGraph slot for the current launch
+    template<typename T>
+    T& getArgument(size_t slot) const {
+        if (arguments_ == nullptr || slot >= arguments_->size() || (*arguments_)[slot] == nullptr) {
+            throw std::out_of_range("Graph argument slot " + std::to_string(slot) + " is not bound");
+        }
+        return *static_cast<T*>((*arguments_)[slot]);
+    }
+
 private:
     int current_device_{0};
+    size_t worker_index_{Scheduler::kNotAWorker};
+    void* scratch_{nullptr};
+    size_t scratch_size_{0};
+    const std::vector<void*>* arguments_{nullptr};
+    const Task* current_task_{nullptr};
     std::unordered_map<void*, size_t> allocations_;
     std::mutex context_mutex_;
+
+    friend class Scheduler;
+    friend class ExecutableGraph;
 };
 
+template<typename F, typename... Args>
+auto Scheduler::submitTask(F&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<F, Args...>>
+{
+    using Result = std::invoke_result_t<F, Args...>;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<Result> future = packaged->get_future();
+    submit(makeTask([packaged](ExecutionContext&) { (*packaged)(); }));
+    return future;
+}
+
 } // namespace runtime
 } // namespace uta
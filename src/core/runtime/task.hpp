@@ -5,6 +5,7 @@
 #include <functional>
 #include <chrono>
 #include <any>
+#include <atomic>
 #include <vector>
 #include "scheduler.hpp"
 
@@ -32,7 +33,8 @@ public:
         
         try {
             function_(context);
-            status_ = TaskStatus::COMPLETED;
+            // A kernel that saw its token may have stopped early
+            status_ = token_.isCancelled() ? TaskStatus::CANCELLED : TaskStatus::COMPLETED;
         } catch (...) {
             status_ = TaskStatus::FAILED;
             throw;
@@ -42,20 +44,86 @@ public:
     }
 
     // task control
+    //
+    // A pending task is marked CANCELLED and will not run; a running one
+    // only sees its token set. Tasks that cannot be cancelled or have
+    // already finished are left alone.
     virtual void cancel() {
-        status_ = TaskStatus::CANCELLED;
+        TaskStatus status = status_.load();
+        if (!isCancellable() || isFinished(status)) {
+            return;
+        }
+        token_.cancel();
+        status_.compare_exchange_strong(status, TaskStatus::CANCELLED);
+    }
+
+    // cancel(), reporting whether it applied: false if the task cannot be
+    // cancelled or has already finished
+    bool tryCancel() {
+        if (!isCancellable() || isFinished(status_.load())) {
+            return false;
+        }
+        cancel();
+        return true;
     }
 
     virtual bool isCancellable() const {
         return true;
     }
 
+    bool isCancelled() const { return token_.isCancelled(); }
+    CancellationToken getCancellationToken() const { return token_; }
+
+    // Back to PENDING with an uncancelled token, before running the task again
+    void reset() {
+        status_ = TaskStatus::PENDING;
+        if (token_.isCancelled()) {
+            token_ = CancellationToken();
+        }
+    }
+
     // attribute access
     const std::string& getName() const { return name_; }
     TaskPriority getPriority() const { return priority_; }
-    TaskStatus getStatus() const { return status_; }
+    TaskStatus getStatus() const { return status_.load(); }
+
+    // NUMA node whose workers should run this task first, -1 for any; e.g.
+    // CpuTopology::nodeOfAddress on the task's input data
+    void setLocalityHint(int numa_node) { locality_hint_ = numa_node; }
+    int getLocalityHint() const { return locality_hint_; }
+
+    // Buffers the task reads and writes. With PlacementPolicy::DATA_LOCALITY
+    // the task is queued on the worker that last wrote most of its input
+    // bytes, and its outputs are recorded as resident on the worker it ran on.
+    struct DataAccess {
+        const void* buffer;
+        size_t bytes;
+    };
+
+    void addInput(const void* buffer, size_t bytes) { inputs_.push_back(DataAccess{buffer, bytes}); }
+    void addOutput(const void* buffer, size_t bytes) { outputs_.push_back(DataAccess{buffer, bytes}); }
+    const std::vector<DataAccess>& getInputs() const { return inputs_; }
+    const std::vector<DataAccess>& getOutputs() const { return outputs_; }
+
+    // Absolute completion deadline, used by DeadlineScheduler and counted in
+    // the scheduler's deadline metrics; time_point::max() for none
+    void setDeadline(std::chrono::steady_clock::time_point deadline) { deadline_ = deadline; }
+    std::chrono::steady_clock::time_point getDeadline() const { return deadline_; }
+    bool hasDeadline() const { return deadline_ != std::chrono::steady_clock::time_point::max(); }
     
     // time statistics
+    void markEnqueued() {
+        enqueue_time_ = std::chrono::steady_clock::now();
+    }
+
+    std::chrono::duration<double> getWaitTime() const {
+        if (enqueue_time_ == std::chrono::steady_clock::time_point() ||
+            start_time_ == std::chrono::steady_clock::time_point()) {
+            return std::chrono::duration<double>::zero();
+        }
+        return start_time_ - enqueue_time_;
+    }
+
     std::chrono::duration<double> getExecutionTime() const {
         if (start_time_ == std::chrono::steady_clock::time_point() ||
             end_time_ == std::chrono::steady_clock::time_point()) {
@@ -65,10 +133,21 @@ public:
     }
 
 protected:
+    static bool isFinished(TaskStatus status) {
+        return status == TaskStatus::COMPLETED || status == TaskStatus::FAILED ||
+               status == TaskStatus::CANCELLED;
+    }
+
     std::string name_;
     TaskFunction function_;
     TaskPriority priority_;
-    TaskStatus status_;
+    std::atomic<TaskStatus> status_;
+    CancellationToken token_;
+    int locality_hint_{-1};
+    std::vector<DataAccess> inputs_;
+    std::vector<DataAccess> outputs_;
+    std::chrono::steady_clock::time_point deadline_{std::chrono::steady_clock::time_point::max()};
+    std::chrono::steady_clock::time_point enqueue_time_;
     std::chrono::steady_clock::time_point start_time_;
     std::chrono::steady_clock::time_point end_time_;
 };
@@ -92,9 +171,15 @@ public:
     int getDeviceId() const { return device_id_; }
     size_t getMemoryRequirement() const { return memory_requirement_; }
 
+    // Host scratch planned for the task by ExecutableGraph, apart from the
+    // device memory requirement used for admission
+    void setScratchRequirement(size_t bytes) { scratch_requirement_ = bytes; }
+    size_t getScratchRequirement() const { return scratch_requirement_; }
+
 private:
     int device_id_;
     size_t memory_requirement_;
+    size_t scratch_requirement_{0};
 };
 
 // communication task
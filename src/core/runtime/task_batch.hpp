@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "scheduler.hpp"
+
+namespace uta {
+namespace runtime {
+
+// Type-erased void() callable stored in place; callables too large for the
+// buffer fall back to one heap allocation
+class InlineFunction {
+public:
+    static constexpr size_t kStorageSize = 56;
+
+    InlineFunction() = default;
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    template<typename F>
+    void emplace(F&& function) {
+        using Function = std::decay_t<F>;
+        if constexpr (sizeof(Function) <= kStorageSize && alignof(Function) <= kAlignment) {
+            new (storage_) Function(std::forward<F>(function));
+            call_ = [](void* storage) {
+                Function& stored = *static_cast<Function*>(storage);
+                struct Destroy {
+                    Function& function;
+                    ~Destroy() { function.~Function(); }
+                } destroy{stored};
+                stored();
+            };
+        } else {
+            *reinterpret_cast<Function**>(storage_) = new Function(std::forward<F>(function));
+            call_ = [](void* storage) {
+                std::unique_ptr<Function> stored(*static_cast<Function**>(storage));
+                (*stored)();
+            };
+        }
+    }
+
+    // Call once and destroy, also when the call throws
+    void invoke() { std::exchange(call_, nullptr)(storage_); }
+
+private:
+    static constexpr size_t kAlignment = 16;
+
+    alignas(kAlignment) unsigned char storage_[kStorageSize];
+    void (*call_)(void*) = nullptr;
+};
+
+static_assert(sizeof(InlineFunction) == 64, "InlineFunction should fill one cache line");
+
+// Batches tiny fire-and-forget tasks
+//
+// post() stores the callable in place in the current chunk; each full chunk
+// of kChunkSize tasks goes to the scheduler as a single work item, so the
+// per-task cost is a copy into the chunk and an indirect call, with no Task,
+// shared_ptr, std::function or name string. Chunks are recycled once run.
+// A batch belongs to the thread that posts to it; wait() (also run by the
+// destructor) flushes the last chunk and helps run queued work until every
+// posted task has finished, then rethrows the first exception, if any.
+class TaskBatch {
+public:
+    static constexpr size_t kChunkSize = 32;
+
+    explicit TaskBatch(size_t tier = static_cast<size_t>(TaskPriority::NORMAL),
+                       Scheduler& scheduler = Scheduler::getInstance())
+        : scheduler_(scheduler)
+        , tier_(tier)
+    {}
+
+    ~TaskBatch() {
+        try {
+            wait();
+        } catch (...) {
+            // Errors are only reported through wait()
+        }
+        reclaim();
+        while (free_ != nullptr) {
+            Chunk* next = free_->next_free;
+            delete free_;
+            free_ = next;
+        }
+    }
+
+    TaskBatch(const TaskBatch&) = delete;
+    TaskBatch& operator=(const TaskBatch&) = delete;
+
+    template<typename F>
+    void post(F&& function) {
+        if (current_ == nullptr) {
+            current_ = acquire();
+        }
+        // Count the slot only once the callable is in it; a throwing copy
+        // leaves the chunk as it was
+        current_->functions[current_->count].emplace(std::forward<F>(function));
+        current_->count++;
+        posted_++;
+        if (current_->count == kChunkSize) {
+            flush();
+        }
+    }
+
+    // Hand the partially filled chunk to the scheduler
+    void flush() {
+        Chunk* chunk = std::exchange(current_, nullptr);
+        if (chunk == nullptr) {
+            return;
+        }
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        // Without a running scheduler the chunk runs here
+        if (scheduler_.getNumWorkers() == 0 || !scheduler_.tryDispatch(chunk, tier_)) {
+            ExecutionContext context;
+            chunk->run(context);
+        }
+    }
+
+    void wait() {
+        flush();
+        while (pending_.load(std::memory_order_acquire) != 0) {
+            if (!scheduler_.runPendingWork()) {
+                std::this_thread::yield();
+            }
+        }
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+    // Tasks posted over the batch's lifetime
+    size_t size() const { return posted_; }
+
+private:
+    struct Chunk : WorkItem {
+        explicit Chunk(TaskBatch* owner) : batch(owner) {}
+
+        void run(ExecutionContext&) override {
+            size_t failed = 0;
+            for (size_t i = 0; i < count; ++i) {
+                try {
+                    functions[i].invoke();
+                } catch (...) {
+                    batch->fail(std::current_exception());
+                    failed++;
+                }
+            }
+            auto& metrics = batch->scheduler_.metrics_;
+            metrics.completed_tasks.fetch_add(count - failed, std::memory_order_relaxed);
+            if (failed > 0) {
+                metrics.failed_tasks.fetch_add(failed, std::memory_order_relaxed);
+            }
+            count = 0;
+            TaskBatch* owner = batch;
+            owner->recycle(this);
+            // The batch may be destroyed as soon as this lands
+            owner->pending_.fetch_sub(1, std::memory_order_release);
+        }
+
+        InlineFunction functions[kChunkSize];
+        size_t count{0};
+        TaskBatch* batch;
+        Chunk* next_free{nullptr};
+    };
+
+    Chunk* acquire() {
+        if (free_ == nullptr) {
+            reclaim();
+        }
+        if (free_ == nullptr) {
+            return new Chunk(this);
+        }
+        Chunk* chunk = free_;
+        free_ = chunk->next_free;
+        return chunk;
+    }
+
+    // Take chunks workers returned; only the owning thread pops
+    void reclaim() {
+        Chunk* returned = returned_.exchange(nullptr, std::memory_order_acquire);
+        while (returned != nullptr) {
+            Chunk* next = returned->next_free;
+            returned->next_free = free_;
+            free_ = returned;
+            returned = next;
+        }
+    }
+
+    void recycle(Chunk* chunk) {
+        Chunk* head = returned_.load(std::memory_order_relaxed);
+        do {
+            chunk->next_free = head;
+        } while (!returned_.compare_exchange_weak(head, chunk, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    }
+
+    void fail(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+            error_ = error;
+        }
+    }
+
+    Scheduler& scheduler_;
+    size_t tier_;
+    Chunk* current_{nullptr};
+    Chunk* free_{nullptr};                      // owner-only
+    std::atomic<Chunk*> returned_{nullptr};     // pushed by workers
+    std::atomic<size_t> pending_{0};
+    size_t posted_{0};
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+};
+
+} // namespace runtime
+} // namespace uta
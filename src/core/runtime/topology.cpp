@@ -0,0 +1,210 @@
+#include "topology.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace uta {
+namespace runtime {
+
+namespace {
+
+// from <numaif.h>, which would pull in libnuma
+constexpr unsigned long kMpolFNode = 1 << 0;
+constexpr unsigned long kMpolFAddr = 1 << 1;
+
+bool readLine(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return static_cast<bool>(std::getline(file, line));
+}
+
+int readInt(const std::string& path, int fallback) {
+    std::string line;
+    if (!readLine(path, line)) {
+        return fallback;
+    }
+    try {
+        return std::stoi(line);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+} // namespace
+
+CpuTopology& CpuTopology::getInstance() {
+    static CpuTopology instance = detect();
+    return instance;
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty() || item == "\n") {
+            continue;
+        }
+        try {
+            size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // malformed entry, skip it
+        }
+    }
+    return cpus;
+}
+
+CpuTopology CpuTopology::detect(const std::string& sysfs_root, bool respect_affinity_mask) {
+    CpuTopology topology;
+
+    std::string line;
+    std::vector<int> online;
+    if (readLine(sysfs_root + "/cpu/online", line)) {
+        online = parseCpuList(line);
+    }
+    if (online.empty()) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < std::max(count, 1L); ++cpu) {
+            online.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    std::map<int, int> node_of;
+    if (readLine(sysfs_root + "/node/online", line)) {
+        for (int node : parseCpuList(line)) {
+            std::string path = sysfs_root + "/node/node" + std::to_string(node) + "/cpulist";
+            std::string cpulist;
+            if (readLine(path, cpulist)) {
+                for (int cpu : parseCpuList(cpulist)) {
+                    node_of[cpu] = node;
+                }
+            }
+        }
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    bool have_mask = respect_affinity_mask && sched_getaffinity(0, sizeof(mask), &mask) == 0;
+
+    for (int cpu : online) {
+        if (have_mask && cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &mask)) {
+            continue;
+        }
+        std::string base = sysfs_root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        auto node = node_of.find(cpu);
+        topology.cpus_.push_back(Cpu{
+            cpu,
+            readInt(base + "core_id", cpu),
+            readInt(base + "physical_package_id", 0),
+            node == node_of.end() ? 0 : node->second
+        });
+    }
+    return topology;
+}
+
+std::vector<int> CpuTopology::getNodes() const {
+    std::set<int> nodes;
+    for (const auto& cpu : cpus_) {
+        nodes.insert(cpu.node);
+    }
+    return std::vector<int>(nodes.begin(), nodes.end());
+}
+
+std::vector<CpuTopology::Placement> CpuTopology::assign(AffinityPolicy policy,
+                                                        size_t num_workers) const {
+    std::vector<Placement> placements(num_workers, Placement{-1, {}});
+    if (policy == AffinityPolicy::NONE || cpus_.empty()) {
+        return placements;
+    }
+
+    // Hyperthread rank: 0 for the first CPU of a physical core, 1 for its sibling...
+    std::map<std::pair<int, int>, int> siblings;
+    std::vector<int> rank(cpus_.size());
+    std::vector<size_t> order(cpus_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return cpus_[a].id < cpus_[b].id;
+    });
+    for (size_t i : order) {
+        rank[i] = siblings[{cpus_[i].package, cpus_[i].core}]++;
+    }
+
+    if (policy == AffinityPolicy::COMPACT) {
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            const Cpu& x = cpus_[a];
+            const Cpu& y = cpus_[b];
+            return std::tie(x.node, x.package, x.core, x.id) <
+                   std::tie(y.node, y.package, y.core, y.id);
+        });
+        for (size_t w = 0; w < num_workers; ++w) {
+            const Cpu& cpu = cpus_[order[w % order.size()]];
+            placements[w] = Placement{cpu.node, {cpu.id}};
+        }
+        return placements;
+    }
+
+    std::vector<int> nodes = getNodes();
+    std::vector<std::vector<size_t>> per_node(nodes.size());
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+        size_t index = std::lower_bound(nodes.begin(), nodes.end(), cpus_[i].node) - nodes.begin();
+        per_node[index].push_back(i);
+    }
+
+    if (policy == AffinityPolicy::NUMA_POOLS) {
+        for (size_t w = 0; w < num_workers; ++w) {
+            size_t index = w * nodes.size() / num_workers;
+            Placement placement{nodes[index], {}};
+            for (size_t i : per_node[index]) {
+                placement.cpus.push_back(cpus_[i].id);
+            }
+            std::sort(placement.cpus.begin(), placement.cpus.end());
+            placements[w] = std::move(placement);
+        }
+        return placements;
+    }
+
+    // SCATTER: physical cores before their siblings, alternating between nodes
+    for (auto& list : per_node) {
+        std::sort(list.begin(), list.end(), [&](size_t a, size_t b) {
+            const Cpu& x = cpus_[a];
+            const Cpu& y = cpus_[b];
+            return std::tie(rank[a], x.package, x.core, x.id) <
+                   std::tie(rank[b], y.package, y.core, y.id);
+        });
+    }
+    std::vector<size_t> scattered;
+    for (size_t position = 0; scattered.size() < cpus_.size(); ++position) {
+        for (const auto& list : per_node) {
+            if (position < list.size()) {
+                scattered.push_back(list[position]);
+            }
+        }
+    }
+    for (size_t w = 0; w < num_workers; ++w) {
+        const Cpu& cpu = cpus_[scattered[w % scattered.size()]];
+        placements[w] = Placement{cpu.node, {cpu.id}};
+    }
+    return placements;
+}
+
+int CpuTopology::nodeOfAddress(const void* address) {
+    int node = -1;
+    long result = syscall(SYS_get_mempolicy, &node, nullptr, 0UL,
+                          const_cast<void*>(address), kMpolFNode | kMpolFAddr);
+    return result == 0 ? node : -1;
+}
+
+} // namespace runtime
+} // namespace uta
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace uta {
+namespace runtime {
+
+// worker thread placement
+enum class AffinityPolicy {
+    NONE,           // no pinning, the OS places threads
+    COMPACT,        // fill hyperthreads, then cores, then sockets
+    SCATTER,        // one thread per physical core, spread across NUMA nodes
+    NUMA_POOLS      // workers split evenly across nodes, each pinned to its node
+};
+
+// CPU and NUMA topology read from sysfs
+class CpuTopology {
+public:
+    struct Cpu {
+        int id;
+        int core;
+        int package;
+        int node;
+    };
+
+    // Where a worker may run; empty cpus means unpinned
+    struct Placement {
+        int node;
+        std::vector<int> cpus;
+    };
+
+    // Topology of this machine, restricted to the CPUs this process may use
+    static CpuTopology& getInstance();
+
+    // Reads <sysfs_root>/cpu and <sysfs_root>/node; missing files fall back
+    // to one core per CPU on node 0
+    static CpuTopology detect(const std::string& sysfs_root = "/sys/devices/system",
+                              bool respect_affinity_mask = true);
+
+    const std::vector<Cpu>& getCpus() const { return cpus_; }
+    std::vector<int> getNodes() const;
+    size_t getNumNodes() const { return getNodes().size(); }
+
+    std::vector<Placement> assign(AffinityPolicy policy, size_t num_workers) const;
+
+    // NUMA node holding the page at address, -1 if unknown
+    static int nodeOfAddress(const void* address);
+
+    // sysfs list format, "0-2,8" -> {0, 1, 2, 8}
+    static std::vector<int> parseCpuList(const std::string& list);
+
+private:
+    std::vector<Cpu> cpus_;
+};
+
+} // namespace runtime
+} // namespace uta
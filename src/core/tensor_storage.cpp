@@ -0,0 +1,398 @@
+#include "tensor_storage.hpp"
+#include "memory_manager.hpp"
+#include "memory_budget.hpp"
+#include "runtime/copy_engine.hpp"
+#include "io/tensor_file.hpp"
+#include <uta/uta.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace uta {
+namespace core {
+
+namespace {
+
+std::atomic<size_t> g_shares{0};
+std::atomic<size_t> g_materializations{0};
+std::atomic<size_t> g_bytes_materialized{0};
+
+thread_local TensorScope* t_scope = nullptr;
+
+std::shared_ptr<TensorStorage> allocateFor(Device& device, size_t size) {
+    if (device.getType() == DeviceType::CPU) {
+        return TensorStorage::allocate(size);
+    }
+    // Under a memory limit the tensor is an evictable buffer; allocating it
+    // may evict colder ones and throws once nothing more can be evicted
+    DeviceKey key{device.getType(), device.getId()};
+    if (MemoryBudget::getInstance().isLimited(key)) {
+        return TensorStorage::manage(MemoryBudget::getInstance().allocate(key, size));
+    }
+    auto& memory = MemoryManager::getInstance();
+    void* data = memory.allocateDevice(size, device);
+    return TensorStorage::adopt(data, size, [&memory, &device](void* ptr) {
+        memory.freeDevice(ptr, device);
+    });
+}
+
+} // namespace
+
+std::shared_ptr<TensorStorage> TensorStorage::allocate(size_t size) {
+    void* data = std::aligned_alloc(64, (std::max<size_t>(size, 1) + 63) / 64 * 64);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return adopt(data, size, [](void* ptr) { std::free(ptr); });
+}
+
+std::shared_ptr<TensorStorage> TensorStorage::adopt(void* data, size_t size, Deleter deleter) {
+    std::shared_ptr<TensorStorage> storage(new TensorStorage());
+    storage->data_ = data;
+    storage->size_ = size;
+    storage->deleter_ = std::move(deleter);
+    return storage;
+}
+
+std::shared_ptr<TensorStorage> TensorStorage::wrap(std::shared_ptr<const void> keep_alive,
+                                                   size_t size) {
+    std::shared_ptr<TensorStorage> storage(new TensorStorage());
+    storage->data_ = const_cast<void*>(keep_alive.get());
+    storage->size_ = size;
+    storage->read_only_ = true;
+    storage->keep_alive_ = std::move(keep_alive);
+    return storage;
+}
+
+std::shared_ptr<TensorStorage> TensorStorage::manage(MemoryBudget::BufferHandle buffer) {
+    if (buffer == nullptr) {
+        throw std::invalid_argument("Managed tensor storage needs a buffer");
+    }
+    std::shared_ptr<TensorStorage> storage(new TensorStorage());
+    storage->managed_ = std::make_unique<Managed>();
+    storage->managed_->buffer = buffer;
+    storage->size_ = MemoryBudget::getInstance().getSize(buffer);
+    return storage;
+}
+
+TensorStorage::~TensorStorage() {
+    // Scopes still holding a pin find the storage expired and skip it
+    if (managed_) {
+        MemoryBudget::getInstance().free(managed_->buffer);
+    }
+    if (deleter_) {
+        deleter_(data_);
+    }
+}
+
+void* TensorStorage::pin() const {
+    TensorScope* scope = t_scope;
+    if (scope == nullptr) {
+        throw std::logic_error("Tensor memory under a device memory limit is only "
+                               "accessible inside a TensorScope");
+    }
+    std::weak_ptr<const TensorStorage> self = weak_from_this();
+    for (const auto& pin : scope->pins_) {
+        if (!pin.storage.owner_before(self) && !self.owner_before(pin.storage)) {
+            return pin.data;
+        }
+    }
+    void* data = MemoryBudget::getInstance().acquire(managed_->buffer);
+    try {
+        scope->pins_.push_back({std::move(self), data});
+    } catch (...) {
+        MemoryBudget::getInstance().release(managed_->buffer);
+        throw;
+    }
+    return data;
+}
+
+void TensorStorage::unpin() const {
+    MemoryBudget::getInstance().release(managed_->buffer);
+}
+
+bool TensorStorage::makeUnique(std::shared_ptr<TensorStorage>& ref,
+                               const AllocateFn& allocate,
+                               const CopyFn& copy) {
+    if (!ref || (ref.use_count() == 1 && !ref->read_only_)) {
+        return false;
+    }
+
+    auto copy_of = allocate(ref->size_);
+    {
+        // Managed buffers stay pinned only for the copy
+        TensorScope scope;
+        copy(copy_of->data(), ref->data(), ref->size_);
+    }
+    ref = std::move(copy_of);
+
+    g_materializations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes_materialized.fetch_add(ref->size_, std::memory_order_relaxed);
+    return true;
+}
+
+void TensorStorage::parallelCopy(void* dst, const void* src, size_t size) {
+    runtime::CopyEngine::getInstance().copy(dst, src, size);
+}
+
+void TensorStorage::recordShare() {
+    g_shares.fetch_add(1, std::memory_order_relaxed);
+}
+
+TensorStorage::CowStats TensorStorage::getStats() {
+    return CowStats{
+        g_shares.load(std::memory_order_relaxed),
+        g_materializations.load(std::memory_order_relaxed),
+        g_bytes_materialized.load(std::memory_order_relaxed)
+    };
+}
+
+} // namespace core
+
+// Tensor pin scopes
+
+TensorScope::TensorScope() : outer_(core::t_scope) {
+    core::t_scope = this;
+}
+
+TensorScope::~TensorScope() {
+    core::t_scope = outer_;
+    for (const auto& pin : pins_) {
+        if (auto storage = pin.storage.lock()) {
+            storage->unpin();
+        }
+    }
+}
+
+// Device memory budget
+
+void Device::configure(const DeviceConfig& config) {
+    if (config.type != getType() || config.device_id != getId()) {
+        throw std::invalid_argument("Device configuration is for another device");
+    }
+    // Spilled tensors move through MemoryManager; the device outlives its budget
+    auto& memory = core::MemoryManager::getInstance();
+    core::MemoryBudget::DeviceOps ops;
+    ops.allocate = [&memory, this](size_t size) {
+        return memory.allocateDevice(size, *this);
+    };
+    ops.free = [&memory, this](void* ptr, size_t) {
+        memory.freeDevice(ptr, *this);
+    };
+    ops.copy_to_host = [&memory, this](void* dst, const void* src, size_t size) {
+        memory.copyDeviceToHost(dst, src, size, *this);
+    };
+    ops.copy_from_host = [&memory, this](void* dst, const void* src, size_t size) {
+        memory.copyHostToDevice(dst, src, size, *this);
+    };
+    ops.move = [&memory, this](void* dst, const void* src, size_t size) {
+        // Compaction only slides blocks down; forward steps no longer than
+        // the distance never overlap what is still to be copied
+        auto* to = static_cast<uint8_t*>(dst);
+        auto* from = static_cast<const uint8_t*>(src);
+        size_t step = std::max<size_t>(from - to, 1);
+        for (size_t offset = 0; offset < size; offset += step) {
+            memory.copyDeviceToDevice(to + offset, from + offset,
+                                      std::min(step, size - offset), *this, *this);
+        }
+    };
+    // Host tensors are not budgeted; configure() ignores CPU devices
+    core::MemoryBudget::getInstance().configure(config, ops);
+}
+
+// Tensor creation
+
+std::shared_ptr<Tensor> Tensor::create(const std::vector<size_t>& shape,
+                                       DataType dtype,
+                                       Device& device) {
+    size_t bytes = io::dataTypeSize(dtype);
+    for (size_t dim : shape) {
+        bytes *= dim;
+    }
+
+    auto tensor = std::make_shared<Tensor>();
+    tensor->shape_ = shape;
+    tensor->dtype_ = dtype;
+    tensor->device_ = &device;
+    tensor->storage_ = core::allocateFor(device, bytes);
+    return tensor;
+}
+
+std::shared_ptr<const Tensor> Tensor::wrap(const std::vector<size_t>& shape,
+                                           DataType dtype,
+                                           Device& device,
+                                           std::shared_ptr<const void> storage) {
+    if (device.getType() != DeviceType::CPU) {
+        throw std::invalid_argument("Only host memory can be wrapped as a tensor");
+    }
+    size_t bytes = io::dataTypeSize(dtype);
+    for (size_t dim : shape) {
+        bytes *= dim;
+    }
+    if (bytes > 0 && storage == nullptr) {
+        throw std::invalid_argument("Wrapped tensor storage must not be null");
+    }
+
+    auto tensor = std::make_shared<Tensor>();
+    tensor->shape_ = shape;
+    tensor->dtype_ = dtype;
+    tensor->device_ = &device;
+    tensor->storage_ = core::TensorStorage::wrap(std::move(storage), bytes);
+    return tensor;
+}
+
+// Tensor information
+
+std::vector<size_t> Tensor::getShape() const {
+    return shape_;
+}
+
+size_t Tensor::getDim() const {
+    return shape_.size();
+}
+
+size_t Tensor::getSize() const {
+    size_t elements = 1;
+    for (size_t dim : shape_) {
+        elements *= dim;
+    }
+    return elements;
+}
+
+DataType Tensor::getDataType() const {
+    return dtype_;
+}
+
+Device& Tensor::getDevice() const {
+    return *device_;
+}
+
+// Tensor storage access
+
+void* Tensor::mutableData() {
+    Device& device = getDevice();
+    if (device.getType() == DeviceType::CPU) {
+        core::TensorStorage::makeUnique(storage_);
+    } else {
+        auto& memory = core::MemoryManager::getInstance();
+        core::TensorStorage::makeUnique(
+            storage_,
+            [&device](size_t size) { return core::allocateFor(device, size); },
+            [&memory, &device](void* dst, const void* src, size_t size) {
+                memory.copyDeviceToDevice(dst, src, size, device, device);
+            });
+    }
+    return storage_ ? storage_->data() : nullptr;
+}
+
+const void* Tensor::constData() const {
+    return storage_ ? storage_->data() : nullptr;
+}
+
+bool Tensor::isReadOnly() const {
+    return storage_ && storage_->isReadOnly();
+}
+
+void Tensor::copyFrom(const Tensor& src) {
+    if (&src == this) {
+        return;
+    }
+    if (getShape() != src.getShape() || getDataType() != src.getDataType()) {
+        throw std::runtime_error("Tensor copy between mismatched shapes or data types");
+    }
+
+    Device& device = getDevice();
+    Device& src_device = src.getDevice();
+    if (&device == &src_device) {
+        // O(1): share the buffer until one side writes. The destination's
+        // earlier mutable data() pointers no longer alias it; the source's
+        // point into the shared buffer, so writes through them land in this
+        // tensor as well, even after a later write un-shares the source
+        storage_ = src.storage_;
+        core::TensorStorage::recordShare();
+        return;
+    }
+
+    // Cross-device copies are eager; never write through storage we share
+    size_t size = src.storage_ ? src.storage_->size() : 0;
+    if (!storage_ || storage_.use_count() > 1 || storage_->isReadOnly()) {
+        storage_ = core::allocateFor(device, size);
+    }
+
+    auto& memory = core::MemoryManager::getInstance();
+    TensorScope scope;
+    void* dst_ptr = storage_->data();
+    const void* src_ptr = src.storage_->data();
+    bool dst_host = device.getType() == DeviceType::CPU;
+    bool src_host = src_device.getType() == DeviceType::CPU;
+    if (dst_host && src_host) {
+        core::TensorStorage::parallelCopy(dst_ptr, src_ptr, size);
+    } else if (src_host) {
+        memory.copyHostToDevice(dst_ptr, src_ptr, size, device);
+    } else if (dst_host) {
+        memory.copyDeviceToHost(dst_ptr, src_ptr, size, src_device);
+    } else {
+        memory.copyDeviceToDevice(dst_ptr, src_ptr, size, src_device, device);
+    }
+}
+
+void Tensor::copyTo(Tensor& dst) {
+    dst.copyFrom(*this);
+}
+
+// Tensor fills
+
+namespace {
+
+// Tile one element of element_size bytes over size bytes of host memory
+void fillPattern(uint8_t* dst, size_t size, const void* value, size_t element_size) {
+    size_t filled = std::min(size, element_size);
+    std::memcpy(dst, value, filled);
+    while (filled < size) {
+        size_t length = std::min(filled, size - filled);
+        std::memcpy(dst + filled, dst, length);
+        filled += length;
+    }
+}
+
+} // namespace
+
+void Tensor::zero() {
+    const uint64_t zero = 0;    // as wide as the widest element
+    fill(&zero);
+}
+
+void Tensor::fill(const void* value) {
+    if (value == nullptr) {
+        throw std::invalid_argument("Tensor fill value must not be null");
+    }
+    size_t size = storage_ ? storage_->size() : 0;
+    if (size == 0) {
+        return;
+    }
+
+    // Writes go through mutableData() so shared storage is never written
+    TensorScope scope;
+    auto* data = static_cast<uint8_t*>(mutableData());
+    size_t element_size = io::dataTypeSize(dtype_);
+    Device& device = getDevice();
+    if (device.getType() == DeviceType::CPU) {
+        fillPattern(data, size, value, element_size);
+        return;
+    }
+
+    // Device memory is not host addressable; upload a filled staging chunk
+    constexpr size_t kStageBytes = 8 << 20;
+    std::vector<uint8_t> stage(std::min(size, kStageBytes / element_size * element_size));
+    fillPattern(stage.data(), stage.size(), value, element_size);
+    auto& memory = core::MemoryManager::getInstance();
+    for (size_t offset = 0; offset < size; offset += stage.size()) {
+        memory.copyHostToDevice(data + offset, stage.data(),
+                                std::min(stage.size(), size - offset), device);
+    }
+}
+
+} // namespace uta
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "memory_budget.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace uta {
+namespace core {
+
+// Reference-counted tensor buffer
+//
+// Tensors hold a shared_ptr<TensorStorage>. Copies between tensors share the
+// storage; the first mutable access through a tensor whose storage is shared
+// (or read-only, e.g. an mmap'd file) materializes a private copy.
+//
+// Managed storage lives in a MemoryBudget buffer. data() pins the buffer in
+// the innermost TensorScope on the calling thread, faulting it back in if it
+// was evicted, and the pointer stays valid until that scope ends; outside
+// any scope the buffer may be evicted or moved by pool compaction. Each scope
+// pins a buffer at most once; the budget counts pins across scopes.
+class TensorStorage : public std::enable_shared_from_this<TensorStorage> {
+public:
+    using Deleter = std::function<void(void*)>;
+    using AllocateFn = std::function<std::shared_ptr<TensorStorage>(size_t)>;
+    using CopyFn = std::function<void(void*, const void*, size_t)>;    // dst, src, size
+
+    // 64-byte aligned host memory
+    static std::shared_ptr<TensorStorage> allocate(size_t size);
+
+    // Adopt memory owned elsewhere
+    static std::shared_ptr<TensorStorage> adopt(void* data, size_t size, Deleter deleter);
+
+    // Read-only view; keep_alive owns the memory
+    static std::shared_ptr<TensorStorage> wrap(std::shared_ptr<const void> keep_alive, size_t size);
+
+    // Evictable storage; takes ownership of the buffer
+    static std::shared_ptr<TensorStorage> manage(MemoryBudget::BufferHandle buffer);
+
+    ~TensorStorage();
+
+    TensorStorage(const TensorStorage&) = delete;
+    TensorStorage& operator=(const TensorStorage&) = delete;
+
+    void* data() { return managed_ ? pin() : data_; }
+    const void* data() const { return managed_ ? pin() : data_; }
+    size_t size() const { return size_; }
+    bool isReadOnly() const { return read_only_; }
+
+    bool isManaged() const { return managed_ != nullptr; }
+
+    // Write hook: leaves ref as the sole owner of writable storage, copying if
+    // it is shared or read-only. Returns true if a copy was made.
+    static bool makeUnique(std::shared_ptr<TensorStorage>& ref,
+                           const AllocateFn& allocate = TensorStorage::allocate,
+                           const CopyFn& copy = parallelCopy);
+
+    // Multi-threaded memcpy for large buffers, through runtime::CopyEngine
+    static void parallelCopy(void* dst, const void* src, size_t size);
+
+    // copy-on-write statistics
+    struct CowStats {
+        size_t shares;
+        size_t materializations;
+        size_t bytes_materialized;
+    };
+
+    static void recordShare();
+    static CowStats getStats();
+
+private:
+    struct Managed {
+        MemoryBudget::BufferHandle buffer;
+    };
+
+    TensorStorage() = default;
+
+    // Pin in the calling thread's innermost TensorScope
+    void* pin() const;
+    void unpin() const;
+
+    friend class uta::TensorScope;
+
+    std::unique_ptr<Managed> managed_;
+    void* data_{nullptr};
+    size_t size_{0};
+    bool read_only_{false};
+    Deleter deleter_;
+    std::shared_ptr<const void> keep_alive_;
+};
+
+} // namespace core
+} // namespace uta
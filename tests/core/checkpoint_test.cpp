@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <uta/uta.hpp>
+#include <uta/distributed.hpp>
+#include "core/io/checkpoint.hpp"
+#include "core/io/checksum.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+class CheckpointTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = ::testing::TempDir() + "checkpoint_test.ckpt";
+        uta::ContextConfig config{};
+        config.enabled_devices = {uta::DeviceType::CPU};
+        context_ = uta::Context::create(config);
+        device_ = context_->getDevice(uta::DeviceType::CPU, 0);
+    }
+
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    std::string path_;
+    std::shared_ptr<uta::Context> context_;
+    std::shared_ptr<uta::Device> device_;
+};
+
+TEST_F(CheckpointTest, Crc32c) {
+    EXPECT_EQ(uta::io::crc32c("123456789", 9), 0xE3069283u);
+    EXPECT_EQ(uta::io::crc32c("6789", 4, uta::io::crc32c("12345", 5)), 0xE3069283u);
+}
+
+TEST_F(CheckpointTest, SaveRestore) {
+    std::vector<float> weights(1 << 20);
+    std::iota(weights.begin(), weights.end(), 0.0f);
+
+    uta::io::CheckpointWriter writer;
+    writer.addBuffer("weights", {weights.size()}, uta::DataType::FLOAT32, weights.data());
+    uta::io::WriteOptions options;
+    options.chunk_size = 64 << 10;
+    writer.save(path_, options);
+
+    uta::io::CheckpointReader reader(path_);
+    EXPECT_TRUE(reader.verify());
+    EXPECT_EQ(reader.info("weights").numChunks(), 64);
+
+    std::vector<float> restored(weights.size());
+    reader.addBuffer("weights", restored.data(), restored.size() * sizeof(float));
+    reader.restore();
+    EXPECT_EQ(restored, weights);
+}
+
+TEST_F(CheckpointTest, DetectsCorruption) {
+    std::vector<float> weights(4096, 1.0f);
+    uta::io::CheckpointWriter writer;
+    writer.addBuffer("weights", {weights.size()}, uta::DataType::FLOAT32, weights.data());
+    writer.save(path_);
+
+    uint64_t offset = uta::io::CheckpointReader(path_).info("weights").offset;
+    FILE* file = std::fopen(path_.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, static_cast<long>(offset + 100), SEEK_SET);
+    std::fputc(0x7f, file);
+    std::fclose(file);
+
+    uta::io::CheckpointReader reader(path_);
+    EXPECT_FALSE(reader.verify());
+
+    std::vector<float> restored(weights.size());
+    reader.addBuffer("weights", restored.data(), restored.size() * sizeof(float));
+    EXPECT_THROW(reader.restore(), std::runtime_error);
+}
+
+TEST_F(CheckpointTest, TensorRoundTrip) {
+    auto tensor = uta::Tensor::create({256, 1024}, uta::DataType::FLOAT32, *device_);
+    float* data = tensor->data<float>();
+    std::iota(data, data + tensor->getSize(), 0.0f);
+
+    uta::io::CheckpointWriter writer;
+    writer.addTensor("weights", *tensor);
+    uta::io::WriteOptions options;
+    options.chunk_size = 64 << 10;
+    writer.save(path_, options);
+
+    auto restored = uta::Tensor::create({256, 1024}, uta::DataType::FLOAT32, *device_);
+    uta::io::CheckpointReader reader(path_);
+    reader.addTensor("weights", *restored);
+    reader.restore();
+    EXPECT_TRUE(std::equal(data, data + tensor->getSize(), restored->data<float>()));
+
+    auto mismatched = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+    EXPECT_THROW(reader.addTensor("weights", *mismatched), std::invalid_argument);
+}
+
+TEST_F(CheckpointTest, DistributedRoundTrip) {
+    auto tensor = uta::distributed::DistributedTensor::create(
+        {4, 4096}, uta::DataType::FLOAT32, {0, 0});
+    tensor->partition({0});
+    auto shards = tensor->getAllTensors();
+    for (size_t i = 0; i < shards.size(); ++i) {
+        float* data = shards[i]->data<float>();
+        std::iota(data, data + shards[i]->getSize(), 1000.0f * i);
+    }
+
+    uta::io::CheckpointWriter writer;
+    writer.addTensor("weights", *tensor);
+    writer.save(path_);
+
+    auto restored = uta::distributed::DistributedTensor::create(
+        {4, 4096}, uta::DataType::FLOAT32, {0, 0});
+    restored->partition({0});
+    uta::io::CheckpointReader reader(path_);
+    EXPECT_TRUE(reader.contains("weights/shard" + std::to_string(shards.size() - 1)));
+    reader.addTensor("weights", *restored);
+    reader.restore();
+
+    auto restored_shards = restored->getAllTensors();
+    ASSERT_EQ(restored_shards.size(), shards.size());
+    for (size_t i = 0; i < shards.size(); ++i) {
+        const float* data = shards[i]->data<float>();
+        EXPECT_TRUE(std::equal(data, data + shards[i]->getSize(),
+                               restored_shards[i]->data<float>()));
+    }
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "core/compiler/compile_queue.hpp"
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace uta::compiler;
+
+namespace {
+
+int genericScale(int x) { return x * 2; }
+int specializedScale(int x) { return x << 1; }
+int specializedOffset(int x) { return x + 1; }
+
+void* entryOf(int (*fn)(int)) { return reinterpret_cast<void*>(fn); }
+
+// Stand-in "code" is the entry point's address
+std::vector<uint8_t> codeOf(int (*fn)(int)) {
+    void* entry = entryOf(fn);
+    std::vector<uint8_t> code(sizeof(entry));
+    std::memcpy(code.data(), &entry, sizeof(entry));
+    return code;
+}
+
+void* loadEntry(const void* code, size_t size) {
+    void* entry = nullptr;
+    if (size == sizeof(entry)) {
+        std::memcpy(&entry, code, sizeof(entry));
+    }
+    return entry;
+}
+
+KernelKey keyOf(const std::string& name) {
+    return KernelKey{name, "host", "O2", "test-1"};
+}
+
+} // namespace
+
+class CompileQueueTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        CompileQueue::getInstance().shutdown();
+        CompileQueue::getInstance().clear();
+        CompileQueue::getInstance().setConfig({0, nullptr});
+    }
+};
+
+TEST_F(CompileQueueTest, FallbackUntilCompiled) {
+    auto& queue = CompileQueue::getInstance();
+    auto stats = queue.getStats();
+    std::atomic<bool> release{false};
+    std::atomic<int> compiles{0};
+    auto compile = [&] {
+        compiles++;
+        while (!release) {
+            std::this_thread::yield();
+        }
+        return codeOf(specializedScale);
+    };
+
+    // Concurrent first launches share one compile
+    std::vector<std::shared_ptr<KernelHandle>> handles(4);
+    std::vector<std::thread> callers;
+    for (size_t t = 0; t < handles.size(); ++t) {
+        callers.emplace_back([&, t] {
+            handles[t] = queue.submit(keyOf("scale:i32"), entryOf(genericScale), compile,
+                                      loadEntry);
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (const auto& handle : handles) {
+        EXPECT_EQ(handle, handles[0]);
+    }
+
+    // The fallback serves launches while the compile runs
+    auto handle = handles[0];
+    EXPECT_FALSE(handle->isSpecialized());
+    EXPECT_EQ(handle->as<int(int)>(), &genericScale);
+    EXPECT_EQ(handle->as<int(int)>()(21), 42);
+
+    release = true;
+    handle->wait();
+    EXPECT_TRUE(handle->isSpecialized());
+    EXPECT_EQ(handle->as<int(int)>(), &specializedScale);
+    EXPECT_EQ(handle->as<int(int)>()(21), 42);
+    EXPECT_EQ(compiles.load(), 1);
+
+    // Later requests get the compiled kernel without compiling
+    EXPECT_EQ(queue.submit(keyOf("scale:i32"), entryOf(genericScale), compile, loadEntry),
+              handle);
+    EXPECT_EQ(queue.find(keyOf("scale:i32")), handle);
+    EXPECT_EQ(compiles.load(), 1);
+
+    auto after = queue.getStats();
+    EXPECT_EQ(after.requests - stats.requests, 5u);
+    EXPECT_EQ(after.deduplicated - stats.deduplicated, 4u);
+    EXPECT_EQ(after.compiled - stats.compiled, 1u);
+    EXPECT_EQ(after.pending, 0u);
+
+    // clear() forgets compiled kernels, outstanding handles keep theirs
+    queue.clear();
+    EXPECT_EQ(queue.find(keyOf("scale:i32")), nullptr);
+    EXPECT_EQ(handle->as<int(int)>(), &specializedScale);
+}
+
+TEST_F(CompileQueueTest, FailedCompile) {
+    auto& queue = CompileQueue::getInstance();
+    auto stats = queue.getStats();
+
+    auto handle = queue.submit(keyOf("offset:i32"), entryOf(genericScale),
+                               []() -> std::vector<uint8_t> {
+                                   throw std::runtime_error("unsupported target");
+                               },
+                               loadEntry);
+    EXPECT_THROW(handle->wait(), std::runtime_error);
+    EXPECT_FALSE(handle->isSpecialized());
+    EXPECT_EQ(handle->as<int(int)>(), &genericScale);
+    EXPECT_EQ(queue.getStats().failed - stats.failed, 1u);
+
+    // The key is free again; a retry compiles
+    EXPECT_EQ(queue.find(keyOf("offset:i32")), nullptr);
+    auto retry = queue.submit(keyOf("offset:i32"), entryOf(genericScale),
+                              [] { return codeOf(specializedOffset); }, loadEntry);
+    EXPECT_NE(retry, handle);
+    retry->wait();
+    EXPECT_EQ(retry->as<int(int)>()(1), 2);
+
+    // A compile that produces nothing is a failure too, as is code that
+    // does not load
+    auto empty = queue.submit(keyOf("empty"), entryOf(genericScale),
+                              [] { return std::vector<uint8_t>(); }, loadEntry);
+    EXPECT_THROW(empty->wait(), std::runtime_error);
+    EXPECT_EQ(empty->as<int(int)>(), &genericScale);
+    auto unloadable = queue.submit(keyOf("unloadable"), entryOf(genericScale),
+                                   [] { return std::vector<uint8_t>(3, 0); }, loadEntry);
+    EXPECT_THROW(unloadable->wait(), std::runtime_error);
+}
+
+TEST_F(CompileQueueTest, WarmStartFromCache) {
+    auto& queue = CompileQueue::getInstance();
+    std::string directory = ::testing::TempDir() + "compile_queue_test_" +
+                            std::to_string(::getpid());
+    auto cache = std::make_shared<KernelCache>(directory);
+    queue.setConfig({1, cache});
+    auto stats = queue.getStats();
+
+    std::atomic<int> compiles{0};
+    auto compile = [&] {
+        compiles++;
+        return codeOf(specializedScale);
+    };
+    auto first = queue.submit(keyOf("cached:i32"), entryOf(genericScale), compile, loadEntry);
+    first->wait();
+    EXPECT_EQ(compiles.load(), 1);
+    EXPECT_EQ(cache->getStats().stores, 1u);
+
+    // As after a restart: nothing in process, the cache is populated
+    queue.clear();
+    auto second = queue.submit(keyOf("cached:i32"), entryOf(genericScale), compile, loadEntry);
+    EXPECT_NE(second, first);
+    EXPECT_TRUE(second->isSpecialized());
+    EXPECT_EQ(second->as<int(int)>(), &specializedScale);
+    EXPECT_EQ(compiles.load(), 1);
+
+    auto after = queue.getStats();
+    EXPECT_EQ(after.cache_hits - stats.cache_hits, 1u);
+    EXPECT_EQ(after.compiled - stats.compiled, 1u);
+    EXPECT_EQ(after.pending, 0u);
+
+    queue.shutdown();
+    cache->clear();
+    ::rmdir(directory.c_str());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "core/runtime/event.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace uta::runtime;
+
+class EventTest : public ::testing::Test {};
+
+TEST_F(EventTest, EventBus) {
+    struct Counter : EventListener {
+        void onEvent(const EventRecord& event) override {
+            EXPECT_EQ(event.type, EventType::MEMORY_ALLOCATED);
+            bytes += event.value;
+        }
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    auto& events = EventManager::getInstance();
+    auto counter = std::make_shared<Counter>();
+    events.registerListener(EventType::MEMORY_ALLOCATED, counter);
+    events.setHistoryCapacity(100);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&events] {
+            for (int i = 0; i < 50; ++i) {
+                events.dispatchEvent(MemoryEvent(EventType::MEMORY_ALLOCATED, 10, 0));
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    events.addTypeFilter(EventType::TASK_START);
+    events.dispatchEvent(TaskEvent(EventType::TASK_START, "filtered", "0"));
+    events.dispatchEvent(TaskEvent(EventType::TASK_COMPLETE, "a very long task name that gets cut", "1"));
+    events.flush();
+
+    EXPECT_EQ(counter->bytes.load(), 4u * 50 * 10);
+    auto history = events.getEventHistory(start, std::chrono::steady_clock::now());
+    ASSERT_EQ(history.size(), 100u);
+    for (size_t i = 1; i < history.size(); ++i) {
+        EXPECT_LE(history[i - 1].timestamp_ns, history[i].timestamp_ns);
+    }
+    EXPECT_EQ(history.back().type, EventType::TASK_COMPLETE);
+    EXPECT_EQ(history.back().getText().size(), sizeof(EventRecord::text) - 1);
+
+    events.unregisterListener(EventType::MEMORY_ALLOCATED, counter);
+    events.removeTypeFilter(EventType::TASK_START);
+}
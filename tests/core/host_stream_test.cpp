@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "core/runtime/scheduler.hpp"
+#include "core/runtime/host_stream.hpp"
+#include <uta/uta.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace uta::runtime;
+
+class HostStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Scheduler::getInstance().initialize(4);
+    }
+
+    void TearDown() override {
+        Scheduler::getInstance().shutdown();
+    }
+};
+
+TEST_F(HostStreamTest, CrossStreamEvents) {
+    uta::Stream producer;
+    uta::Stream consumer;
+    uta::Event start;
+    uta::Event ready;
+    std::vector<int> order;
+    std::mutex order_mutex;
+    auto append = [&](int value) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(value);
+    };
+
+    // consumer must not pass its wait until producer reaches the record
+    start.record(producer);
+    producer.launch([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        append(1);
+    });
+    ready.record(producer);
+    consumer.wait(ready);
+    consumer.launch([&] { append(2); });
+
+    std::vector<int> buffer(1024, 0);
+    std::vector<int> copy(1024, 1);
+    consumer.memset(buffer.data(), 0x7f, buffer.size() * sizeof(int));
+    consumer.memcpy(copy.data(), buffer.data(), buffer.size() * sizeof(int));
+
+    std::atomic<bool> called{false};
+    consumer.addCallback([&] { called = true; });
+    consumer.synchronize();
+
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+    EXPECT_TRUE(called);
+    EXPECT_EQ(copy[1023], 0x7f7f7f7f);
+    EXPECT_TRUE(consumer.query());
+    EXPECT_TRUE(ready.query());
+    EXPECT_GE(ready.elapsed(start), 20.0f);
+
+    // Re-recording starts a new generation
+    producer.launch([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+    ready.record(producer);
+    std::atomic<bool> recorded{false};
+    ready.addCallback([&] { recorded = true; });
+    ready.synchronize();
+    // Callbacks run on the completing thread, possibly after waiters wake
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!recorded && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(recorded);
+
+    uta::Event never_recorded;
+    EXPECT_THROW(never_recorded.elapsed(start), std::runtime_error);
+    producer.launch([] { throw std::runtime_error("kernel failed"); });
+    EXPECT_THROW(producer.synchronize(), std::runtime_error);
+    producer.synchronize();
+}
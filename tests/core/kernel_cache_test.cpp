@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "core/compiler/kernel_cache.hpp"
+#include <uta/uta.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace uta::compiler;
+
+class KernelCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = ::testing::TempDir() + "kernel_cache_test_" + std::to_string(::getpid());
+        directory_ = root_ + "/jit";
+        key_ = KernelKey{"kernel void add() {}", "sm_80", "O3 fast-math", "llvm-17"};
+    }
+
+    void TearDown() override {
+        KernelCache(directory_).clear();
+        ::rmdir(directory_.c_str());
+        ::rmdir(root_.c_str());
+    }
+
+    std::string entryPath() const {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx",
+                      static_cast<unsigned long long>(KernelCache::hashKey(key_)));
+        return directory_ + "/" + name + ".kernel";
+    }
+
+    std::string root_;
+    std::string directory_;
+    KernelKey key_;
+};
+
+TEST_F(KernelCacheTest, WarmStart) {
+    std::vector<uint8_t> code(1000);
+    for (size_t i = 0; i < code.size(); ++i) {
+        code[i] = static_cast<uint8_t>(i * 7);
+    }
+    {
+        KernelCache cache(directory_);
+        EXPECT_EQ(cache.load(key_), nullptr);
+        cache.store(key_, code.data(), code.size());
+    }
+
+    // A new cache on the same directory, as after a restart
+    KernelCache cache(directory_);
+    auto kernel = cache.load(key_);
+    ASSERT_NE(kernel, nullptr);
+    ASSERT_EQ(kernel->size, code.size());
+    EXPECT_EQ(std::memcmp(kernel->code, code.data(), code.size()), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(kernel->code) % 64, 0u);
+    EXPECT_EQ(cache.getStats().hits, 1u);
+
+    // Every key field is part of the identity
+    for (std::string KernelKey::*field : {&KernelKey::source, &KernelKey::target_arch,
+                                          &KernelKey::options, &KernelKey::compiler_version}) {
+        KernelKey other = key_;
+        (other.*field) += "x";
+        EXPECT_EQ(cache.load(other), nullptr);
+    }
+    EXPECT_EQ(cache.getStats().misses, 4u);
+    EXPECT_EQ(cache.getStats().rejected, 0u);
+
+    cache.remove(key_);
+    EXPECT_EQ(cache.load(key_), nullptr);
+}
+
+TEST_F(KernelCacheTest, CorruptEntry) {
+    KernelCache cache(directory_);
+    std::vector<uint8_t> code(256, 0xab);
+    cache.store(key_, code.data(), code.size());
+
+    // Flip a code byte behind the cache's back
+    {
+        std::fstream file(entryPath(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put(0);
+    }
+    EXPECT_EQ(cache.load(key_), nullptr);
+    EXPECT_EQ(cache.getStats().rejected, 1u);
+    EXPECT_NE(::access(entryPath().c_str(), F_OK), 0);
+
+    // Truncated files are rejected too
+    cache.store(key_, code.data(), code.size());
+    EXPECT_EQ(::truncate(entryPath().c_str(), 32), 0);
+    EXPECT_EQ(cache.load(key_), nullptr);
+    EXPECT_EQ(cache.getStats().rejected, 2u);
+}
+
+TEST_F(KernelCacheTest, ConcurrentWriters) {
+    std::vector<uint8_t> code(64 << 10, 0x5a);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&] {
+            // Each writer stands in for a separate process
+            KernelCache cache(directory_);
+            for (int i = 0; i < 20; ++i) {
+                cache.store(key_, code.data(), code.size());
+                auto kernel = cache.load(key_);
+                ASSERT_NE(kernel, nullptr);
+                EXPECT_EQ(kernel->size, code.size());
+                EXPECT_EQ(kernel->code[code.size() - 1], 0x5a);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    // Writers leave no temporary files behind
+    size_t files = 0;
+    DIR* dir = ::opendir(directory_.c_str());
+    ASSERT_NE(dir, nullptr);
+    while (const dirent* entry = ::readdir(dir)) {
+        files += entry->d_name[0] != '.';
+    }
+    ::closedir(dir);
+    EXPECT_EQ(files, 1u);
+}
+
+TEST_F(KernelCacheTest, ProcessCache) {
+    uta::ContextConfig config{};
+    EXPECT_EQ(KernelCache::open(config), nullptr);
+
+    // One instance per directory, however it is spelled
+    config.cache_dir = directory_;
+    auto cache = KernelCache::open(config);
+    ASSERT_NE(cache, nullptr);
+    EXPECT_EQ(cache->directory(), directory_);
+    config.cache_dir = directory_ + "/";
+    EXPECT_EQ(KernelCache::open(config), cache);
+
+    std::vector<uint8_t> code(128, 0x3c);
+    cache->store(key_, code.data(), code.size());
+    auto kernel = KernelCache::open(config)->load(key_);
+    ASSERT_NE(kernel, nullptr);
+    EXPECT_EQ(kernel->code[0], 0x3c);
+    EXPECT_EQ(cache->getStats().hits, 1u);
+}
@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+#include "core/memory_budget.hpp"
+#include "core/memory_pool.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using uta::core::DeviceKey;
+using uta::core::MemoryBudget;
+
+// The budget is process-wide; each test configures its own device id
+class MemoryBudgetTest : public ::testing::Test {
+protected:
+    static DeviceKey cuda(int id) { return {uta::DeviceType::CUDA, id}; }
+
+    MemoryBudget::BudgetConfig makeConfig(size_t memory_limit) {
+        MemoryBudget::BudgetConfig config{};
+        config.memory_limit = memory_limit;
+        config.host_spill_limit = SIZE_MAX;
+        return config;
+    }
+
+    void fill(MemoryBudget::BufferHandle buffer, uint8_t value) {
+        auto& budget = MemoryBudget::getInstance();
+        std::memset(budget.acquire(buffer), value, budget.getSize(buffer));
+        budget.release(buffer);
+    }
+
+    bool holds(MemoryBudget::BufferHandle buffer, uint8_t value) {
+        auto& budget = MemoryBudget::getInstance();
+        std::vector<uint8_t> expected(budget.getSize(buffer), value);
+        bool equal = std::memcmp(budget.acquire(buffer), expected.data(), expected.size()) == 0;
+        budget.release(buffer);
+        return equal;
+    }
+};
+
+TEST_F(MemoryBudgetTest, EvictAndFaultBack) {
+    auto& budget = MemoryBudget::getInstance();
+    budget.configure(cuda(100), makeConfig(4096));
+    EXPECT_TRUE(budget.isConfigured(cuda(100)));
+    EXPECT_FALSE(budget.isConfigured(cuda(101)));
+
+    auto a = budget.allocate(cuda(100), 2048);
+    auto b = budget.allocate(cuda(100), 2048);
+    fill(a, 0x11);
+    fill(b, 0x22);
+
+    // The limit is reached; the next allocation evicts one of them
+    auto c = budget.allocate(cuda(100), 2048);
+    EXPECT_NE(budget.isResident(a), budget.isResident(b));
+    EXPECT_EQ(budget.getStats(cuda(100)).resident_bytes, 4096u);
+    EXPECT_EQ(budget.getStats(cuda(100)).host_spilled_bytes, 2048u);
+
+    // Faulting back restores the contents
+    EXPECT_TRUE(holds(a, 0x11));
+    EXPECT_TRUE(holds(b, 0x22));
+    EXPECT_LE(budget.getStats(cuda(100)).resident_bytes, 4096u);
+    EXPECT_GE(budget.getStats(cuda(100)).faults, 1u);
+
+    budget.free(a);
+    budget.free(b);
+    budget.free(c);
+    EXPECT_EQ(budget.getStats(cuda(100)).resident_bytes, 0u);
+    EXPECT_EQ(budget.getStats(cuda(100)).host_spilled_bytes, 0u);
+}
+
+TEST_F(MemoryBudgetTest, PinnedBuffersStay) {
+    auto& budget = MemoryBudget::getInstance();
+    budget.configure(cuda(102), makeConfig(4096));
+
+    auto a = budget.allocate(cuda(102), 4096);
+    void* pinned = budget.acquire(a);
+    EXPECT_THROW(budget.allocate(cuda(102), 1024), std::runtime_error);
+    EXPECT_TRUE(budget.isResident(a));
+    EXPECT_EQ(budget.acquire(a), pinned);
+    budget.release(a);
+    budget.release(a);
+
+    auto b = budget.allocate(cuda(102), 1024);
+    EXPECT_FALSE(budget.isResident(a));
+    EXPECT_THROW(budget.allocate(cuda(102), 8192), std::runtime_error);
+
+    budget.free(a);
+    budget.free(b);
+}
+
+TEST_F(MemoryBudgetTest, FileTier) {
+    auto& budget = MemoryBudget::getInstance();
+    auto config = makeConfig(1 << 20);
+    config.host_spill_limit = 0;
+    config.spill_dir = ::testing::TempDir();
+    budget.configure(cuda(103), config);
+
+    auto a = budget.allocate(cuda(103), 1 << 20);
+    fill(a, 0x5a);
+    auto b = budget.allocate(cuda(103), 1 << 20);
+    EXPECT_FALSE(budget.isResident(a));
+    EXPECT_EQ(budget.getStats(cuda(103)).file_spilled_bytes, size_t(1) << 20);
+
+    EXPECT_TRUE(holds(a, 0x5a));
+    EXPECT_FALSE(budget.isResident(b));
+
+    budget.free(a);
+    budget.free(b);
+    EXPECT_EQ(budget.getStats(cuda(103)).file_spilled_bytes, 0u);
+}
+
+TEST_F(MemoryBudgetTest, DeviceConfigFileTier) {
+    auto& budget = MemoryBudget::getInstance();
+    uta::DeviceConfig device{};
+    device.type = uta::DeviceType::CUDA;
+    device.device_id = 107;
+    device.memory_limit = 4096;
+    device.host_spill_limit = 1024;
+    device.spill_dir = ::testing::TempDir();
+    budget.configure(device);
+
+    // Past the host tier, spills go to files under spill_dir
+    auto a = budget.allocate(cuda(107), 4096);
+    fill(a, 0x66);
+    auto b = budget.allocate(cuda(107), 4096);
+    EXPECT_FALSE(budget.isResident(a));
+    EXPECT_EQ(budget.getStats(cuda(107)).file_spilled_bytes, 4096u);
+    EXPECT_EQ(budget.getStats(cuda(107)).host_spilled_bytes, 0u);
+
+    budget.free(b);
+    EXPECT_TRUE(holds(a, 0x66));
+    budget.free(a);
+}
+
+TEST_F(MemoryBudgetTest, FailedSpillStaysResident) {
+    auto& budget = MemoryBudget::getInstance();
+    auto config = makeConfig(4096);
+    config.ops.copy_to_host = [](void*, const void*, size_t) {
+        throw std::runtime_error("copy failed");
+    };
+    config.ops.copy_from_host = [](void* dst, const void* src, size_t size) {
+        std::memcpy(dst, src, size);
+    };
+    budget.configure(cuda(104), config);
+
+    auto a = budget.allocate(cuda(104), 4096);
+    fill(a, 0x33);
+    EXPECT_THROW(budget.allocate(cuda(104), 1024), std::runtime_error);
+
+    // The victim is still usable and the failed attempt left no accounting behind
+    EXPECT_TRUE(budget.isResident(a));
+    EXPECT_TRUE(holds(a, 0x33));
+    EXPECT_EQ(budget.getStats(cuda(104)).resident_bytes, 4096u);
+    EXPECT_EQ(budget.getStats(cuda(104)).host_spilled_bytes, 0u);
+    EXPECT_EQ(budget.getStats(cuda(104)).evictions, 0u);
+
+    budget.free(a);
+}
+
+TEST_F(MemoryBudgetTest, FailedFaultStaysSpilled) {
+    auto& budget = MemoryBudget::getInstance();
+    static bool fail_copies;
+    fail_copies = false;
+    auto config = makeConfig(4096);
+    config.ops.copy_from_host = [](void* dst, const void* src, size_t size) {
+        if (fail_copies) {
+            throw std::runtime_error("copy failed");
+        }
+        std::memcpy(dst, src, size);
+    };
+    budget.configure(cuda(106), config);
+
+    auto a = budget.allocate(cuda(106), 4096);
+    fill(a, 0x55);
+    auto b = budget.allocate(cuda(106), 2048);
+    EXPECT_FALSE(budget.isResident(a));
+
+    // The failed upload frees its device memory and keeps the host copy
+    fail_copies = true;
+    budget.free(b);
+    EXPECT_THROW(budget.acquire(a), std::runtime_error);
+    EXPECT_FALSE(budget.isResident(a));
+    EXPECT_EQ(budget.getStats(cuda(106)).resident_bytes, 0u);
+    EXPECT_EQ(budget.getStats(cuda(106)).host_spilled_bytes, 4096u);
+
+    fail_copies = false;
+    EXPECT_TRUE(holds(a, 0x55));
+    budget.free(a);
+}
+
+TEST_F(MemoryBudgetTest, Reserve) {
+    auto& budget = MemoryBudget::getInstance();
+    uta::DeviceConfig device{};
+    device.type = uta::DeviceType::CUDA;
+    device.device_id = 105;
+    device.memory_limit = 4096;
+    budget.configure(device);
+
+    // Memory allocated outside the budget pushes managed buffers out
+    auto a = budget.allocate(cuda(105), 4096);
+    fill(a, 0x44);
+    budget.reserve(cuda(105), 2048);
+    EXPECT_FALSE(budget.isResident(a));
+    EXPECT_EQ(budget.getStats(cuda(105)).resident_bytes, 2048u);
+
+    EXPECT_EQ(budget.getStats(cuda(105)).reserved_bytes, 2048u);
+    EXPECT_THROW(budget.reserve(cuda(105), 8192), std::runtime_error);
+
+    // Reservations are never evicted, and running out because of them says so
+    try {
+        budget.reserve(cuda(105), 4096);
+        ADD_FAILURE() << "reservation past the limit succeeded";
+    } catch (const std::runtime_error& error) {
+        EXPECT_NE(std::string(error.what()).find("2048 reserved, 0 pinned"), std::string::npos)
+            << error.what();
+    }
+    budget.unreserve(cuda(105), 2048);
+    EXPECT_EQ(budget.getStats(cuda(105)).resident_bytes, 0u);
+    EXPECT_EQ(budget.getStats(cuda(105)).reserved_bytes, 0u);
+
+    EXPECT_TRUE(holds(a, 0x44));
+    budget.free(a);
+}
+
+TEST_F(MemoryBudgetTest, DeviceKeys) {
+    auto& budget = MemoryBudget::getInstance();
+    budget.configure(cuda(108), makeConfig(4096));
+    EXPECT_TRUE(budget.isLimited(cuda(108)));
+    EXPECT_FALSE(budget.isConfigured({uta::DeviceType::ROCM, 108}));
+
+    // Host memory is never budgeted
+    EXPECT_THROW(budget.configure({uta::DeviceType::CPU, 108}, makeConfig(4096)),
+                 std::invalid_argument);
+    uta::DeviceConfig host{};
+    host.type = uta::DeviceType::CPU;
+    host.device_id = 108;
+    host.memory_limit = 4096;
+    budget.configure(host);
+    EXPECT_FALSE(budget.isConfigured({uta::DeviceType::CPU, 108}));
+    EXPECT_EQ(budget.getStats(cuda(108)).memory_limit, 4096u);
+}
+
+TEST_F(MemoryBudgetTest, DeviceConfigWithoutLimit) {
+    auto& budget = MemoryBudget::getInstance();
+    uta::DeviceConfig device{};
+    device.type = uta::DeviceType::CUDA;
+    device.device_id = 109;
+    budget.configure(device);
+    EXPECT_FALSE(budget.isConfigured(cuda(109)));
+    EXPECT_FALSE(budget.isLimited(cuda(109)));
+
+    // Dropping the limit later keeps existing buffers but stops managing new ones
+    device.memory_limit = 4096;
+    budget.configure(device);
+    auto a = budget.allocate(cuda(109), 4096);
+    fill(a, 0x77);
+    device.memory_limit = 0;
+    budget.configure(device);
+    EXPECT_FALSE(budget.isLimited(cuda(109)));
+    auto b = budget.allocate(cuda(109), 4096);
+    EXPECT_TRUE(budget.isResident(a));
+    EXPECT_TRUE(holds(a, 0x77));
+    budget.free(a);
+    budget.free(b);
+}
+
+TEST_F(MemoryBudgetTest, CompactingPool) {
+    auto& budget = MemoryBudget::getInstance();
+    uta::DeviceConfig device{};
+    device.type = uta::DeviceType::CUDA;
+    device.device_id = 111;
+    device.memory_limit = 4096;
+    budget.configure(device);
+    uta::core::DevicePool* pool = budget.getPool(cuda(111));
+    ASSERT_NE(pool, nullptr);
+
+    auto a = budget.allocate(cuda(111), 1024);
+    auto b = budget.allocate(cuda(111), 1024);
+    auto c = budget.allocate(cuda(111), 1024);
+    fill(a, 0xa1);
+    fill(c, 0xc1);
+    budget.free(b);
+    void* before = budget.acquire(c);
+    budget.release(c);
+
+    // Pinned buffers stay put; unpinned ones slide down at the safe point
+    void* pinned = budget.acquire(a);
+    EXPECT_TRUE(pool->safePoint());
+    EXPECT_EQ(budget.acquire(a), pinned);
+    budget.release(a);
+    budget.release(a);
+    void* after = budget.acquire(c);
+    budget.release(c);
+    EXPECT_NE(after, before);
+    EXPECT_TRUE(holds(a, 0xa1));
+    EXPECT_TRUE(holds(c, 0xc1));
+
+    // The free space coalesced, so a large buffer fits without evicting
+    auto d = budget.allocate(cuda(111), 2048);
+    EXPECT_EQ(budget.getStats(cuda(111)).evictions, 0u);
+    EXPECT_TRUE(budget.isResident(a));
+    EXPECT_TRUE(budget.isResident(c));
+
+    // Once full, a split pool evicts to make room
+    budget.free(a);
+    auto e = budget.allocate(cuda(111), 2048);
+    EXPECT_EQ(budget.getStats(cuda(111)).evictions, 1u);
+    EXPECT_FALSE(budget.isResident(c));
+    budget.free(c);
+    budget.free(d);
+    budget.free(e);
+    EXPECT_EQ(pool->getStats().used_bytes, 0u);
+}
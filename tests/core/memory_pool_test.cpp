@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "core/memory_pool.hpp"
+#include "core/runtime/scheduler.hpp"
+#include "core/runtime/task.hpp"
+#include "core/runtime/executable_graph.hpp"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using uta::core::DevicePool;
+
+class MemoryPoolTest : public ::testing::Test {
+protected:
+    DevicePool::PoolConfig makeConfig(size_t capacity) {
+        DevicePool::PoolConfig config{};
+        config.capacity = capacity;
+        config.alignment = 64;
+        config.compaction_threshold = 0.5;
+        return config;
+    }
+
+    void fill(DevicePool& pool, DevicePool::Handle allocation, uint8_t value) {
+        std::memset(pool.acquire(allocation), value, pool.getSize(allocation));
+        pool.release(allocation);
+    }
+
+    bool holds(DevicePool& pool, DevicePool::Handle allocation, uint8_t value) {
+        const uint8_t* data = static_cast<const uint8_t*>(pool.acquire(allocation));
+        bool equal = true;
+        for (size_t i = 0; i < pool.getSize(allocation); ++i) {
+            equal = equal && data[i] == value;
+        }
+        pool.release(allocation);
+        return equal;
+    }
+};
+
+TEST_F(MemoryPoolTest, CompactAroundPinned) {
+    DevicePool pool(makeConfig(1024));
+    auto a = pool.allocate(128);
+    auto b = pool.allocate(128);
+    auto c = pool.allocate(128);
+    auto d = pool.allocate(128);
+    fill(pool, b, 0xb0);
+    fill(pool, d, 0xd0);
+    pool.free(a);
+    pool.free(c);
+    EXPECT_EQ(pool.getStats().free_blocks, 3u);
+
+    // A pinned block is a barrier; d slides down against it
+    void* pinned = pool.acquire(b);
+    EXPECT_EQ(pool.compact(), 128u);
+    EXPECT_EQ(pool.address(b), pinned);
+    EXPECT_EQ(pool.address(d), static_cast<uint8_t*>(pinned) + 128);
+    EXPECT_EQ(pool.getStats().largest_free_block, 640u);
+    EXPECT_TRUE(holds(pool, d, 0xd0));
+    pool.release(b);
+
+    // Unpinned, everything coalesces
+    EXPECT_EQ(pool.compact(), 256u);
+    EXPECT_EQ(pool.getStats().free_blocks, 1u);
+    EXPECT_EQ(pool.getStats().fragmentation, 0.0);
+    EXPECT_TRUE(holds(pool, b, 0xb0));
+    EXPECT_TRUE(holds(pool, d, 0xd0));
+
+    // Immovable allocations never move
+    pool.free(b);
+    auto fixed = pool.allocate(64, false);
+    void* fixed_address = pool.address(fixed);
+    pool.compact();
+    EXPECT_EQ(pool.address(fixed), fixed_address);
+
+    pool.free(d);
+    pool.free(fixed);
+    EXPECT_EQ(pool.getStats().used_bytes, 0u);
+}
+
+TEST_F(MemoryPoolTest, SafePoint) {
+    DevicePool pool(makeConfig(1024));
+    std::vector<DevicePool::Handle> allocations;
+    for (int i = 0; i < 8; ++i) {
+        allocations.push_back(pool.allocate(128));
+    }
+
+    // Two 128-byte holes: half the free space is outside the largest block
+    pool.free(allocations[1]);
+    pool.free(allocations[3]);
+    EXPECT_FALSE(pool.safePoint());
+
+    pool.free(allocations[5]);
+    EXPECT_GT(pool.getStats().fragmentation, 0.5);
+    EXPECT_TRUE(pool.safePoint());
+    EXPECT_EQ(pool.getStats().largest_free_block, 384u);
+    EXPECT_EQ(pool.getStats().compactions, 1u);
+
+    for (int i : {0, 2, 4, 6, 7}) {
+        pool.free(allocations[i]);
+    }
+}
+
+TEST_F(MemoryPoolTest, CompactOnFailure) {
+    DevicePool pool(makeConfig(512));
+    auto a = pool.allocate(128);
+    auto b = pool.allocate(128);
+    auto c = pool.allocate(128);
+    pool.free(a);
+
+    // 256 bytes are free but split; only a caller at a safe point compacts
+    EXPECT_THROW(pool.allocate(256), std::runtime_error);
+    EXPECT_EQ(pool.getStats().compactions, 0u);
+    auto d = pool.allocate(256, true, true);
+    EXPECT_EQ(pool.getStats().compactions, 1u);
+    EXPECT_THROW(pool.allocate(64, true, true), std::runtime_error);
+
+    pool.free(b);
+    pool.free(c);
+    pool.free(d);
+}
+
+TEST_F(MemoryPoolTest, AcquireWhileMoving) {
+    DevicePool pool(makeConfig(64 << 10));
+    std::vector<DevicePool::Handle> live;
+    for (int i = 0; i < 32; ++i) {
+        live.push_back(pool.allocate(1024));
+        fill(pool, live.back(), static_cast<uint8_t>(i));
+    }
+
+    // Readers pin and check their blocks while the pool keeps compacting
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = t; i < 32; i += 8) {
+                    if (!holds(pool, live[i], static_cast<uint8_t>(i))) {
+                        mismatches.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    // Churn the odd blocks so the even ones keep moving
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 1; i < 32; i += 8) {
+            pool.free(live[i + 4]);
+            live[i + 4] = nullptr;
+        }
+        pool.compact();
+        for (int i = 1; i < 32; i += 8) {
+            live[i + 4] = pool.allocate(1024);
+            fill(pool, live[i + 4], static_cast<uint8_t>(i + 4));
+        }
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_GT(pool.getStats().bytes_moved, 0u);
+
+    for (auto allocation : live) {
+        pool.free(allocation);
+    }
+}
+
+TEST_F(MemoryPoolTest, GraphSafePoint) {
+    using namespace uta::runtime;
+    auto& scheduler = Scheduler::getInstance();
+    scheduler.initialize(2);
+
+    DevicePool pool(makeConfig(1024));
+    std::vector<DevicePool::Handle> allocations;
+    for (int i = 0; i < 8; ++i) {
+        allocations.push_back(pool.allocate(128));
+    }
+    fill(pool, allocations[7], 0x77);
+
+    // The graph frees every other block; compaction waits for the launch to end
+    auto release = std::make_shared<Task>("release", [&](ExecutionContext&) {
+        for (int i = 0; i < 7; i += 2) {
+            pool.free(allocations[i]);
+        }
+        EXPECT_EQ(pool.getStats().compactions, 0u);
+    });
+    TaskGraph graph;
+    graph.addTask(release);
+    auto executable = ExecutableGraph::capture(scheduler, graph);
+    executable->addSafePoint(&pool);
+    EXPECT_THROW(executable->addSafePoint(nullptr), std::invalid_argument);
+
+    executable->launch().get();
+    EXPECT_EQ(executable->getStats().compactions, 1u);
+    EXPECT_EQ(pool.getStats().free_blocks, 1u);
+    EXPECT_TRUE(holds(pool, allocations[7], 0x77));
+
+    for (int i = 1; i < 8; i += 2) {
+        pool.free(allocations[i]);
+    }
+    scheduler.shutdown();
+}
@@ -0,0 +1,839 @@
+#include <gtest/gtest.h>
+#include "core/runtime/scheduler.hpp"
+#include "core/runtime/task.hpp"
+#include "core/runtime/executable_graph.hpp"
+#include "core/runtime/critical_path_scheduler.hpp"
+#include "core/runtime/deadline_scheduler.hpp"
+#include "core/runtime/parallel.hpp"
+#include "core/runtime/task_batch.hpp"
+#include "core/runtime/coroutine.hpp"
+#include "core/runtime/residency_tracker.hpp"
+#include <uta/uta.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace uta::runtime;
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Scheduler::getInstance().initialize(4);
+    }
+
+    void TearDown() override {
+        Scheduler::getInstance().shutdown();
+    }
+};
+
+TEST_F(SchedulerTest, WorkStealingDeque) {
+    WorkStealingDeque<intptr_t> deque(2);
+    std::atomic<bool> done{false};
+    std::atomic<intptr_t> stolen{0};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&] {
+            intptr_t value;
+            while (!done.load() || !deque.empty()) {
+                if (deque.steal(value)) {
+                    stolen += value;
+                }
+            }
+        });
+    }
+
+    intptr_t expected = 0;
+    intptr_t popped = 0;
+    intptr_t value;
+    for (intptr_t i = 1; i <= 100000; ++i) {
+        deque.push(i);
+        expected += i;
+        if (i % 3 == 0 && deque.pop(value)) {
+            popped += value;
+        }
+    }
+    while (deque.pop(value)) {
+        popped += value;
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    EXPECT_EQ(popped + stolen.load(), expected);
+}
+
+TEST_F(SchedulerTest, SubmitTask) {
+    auto& scheduler = Scheduler::getInstance();
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(scheduler.submitTask([](int x) { return x * 2; }, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(futures[i].get(), i * 2);
+    }
+}
+
+TEST_F(SchedulerTest, NestedDispatch) {
+    struct Fork : WorkItem {
+        Fork(std::atomic<int>& count, int depth) : count(count), depth(depth) {}
+
+        void run(ExecutionContext& context) override {
+            EXPECT_EQ(context.getWorkerIndex(), Scheduler::currentWorker());
+            count++;
+            if (depth > 0) {
+                Scheduler::getInstance().dispatch(new Fork(count, depth - 1), 1);
+                Scheduler::getInstance().dispatch(new Fork(count, depth - 1), 1);
+            }
+            delete this;
+        }
+
+        std::atomic<int>& count;
+        int depth;
+    };
+
+    std::atomic<int> count{0};
+    Scheduler::getInstance().dispatch(new Fork(count, 10), 0);
+    while (count.load() < (1 << 11) - 1) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(Scheduler::currentWorker(), Scheduler::kNotAWorker);
+}
+
+TEST_F(SchedulerTest, ShutdownDrainsQueue) {
+    auto& scheduler = Scheduler::getInstance();
+    size_t completed = scheduler.getMetrics().tasks_completed;
+    std::atomic<int> count{0};
+    for (int i = 0; i < 10000; ++i) {
+        scheduler.submitTask([&count] { count++; });
+    }
+    scheduler.shutdown();
+    EXPECT_EQ(count.load(), 10000);
+    EXPECT_EQ(scheduler.getMetrics().tasks_completed - completed, 10000u);
+}
+
+TEST_F(SchedulerTest, SubmitDuringShutdown) {
+    auto& scheduler = Scheduler::getInstance();
+    for (int round = 0; round < 20; ++round) {
+        // Every submission either throws or runs, none is lost
+        std::atomic<bool> stop{false};
+        std::atomic<int> accepted{0};
+        std::atomic<int> ran{0};
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 4; ++t) {
+            submitters.emplace_back([&] {
+                while (!stop.load()) {
+                    try {
+                        scheduler.submitTask([&ran] { ran++; });
+                        accepted++;
+                    } catch (const std::runtime_error&) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        scheduler.shutdown();
+        EXPECT_THROW(scheduler.submitTask([] {}), std::runtime_error);
+        stop.store(true);
+        for (auto& submitter : submitters) {
+            submitter.join();
+        }
+        EXPECT_EQ(ran.load(), accepted.load());
+        scheduler.initialize(4);
+    }
+}
+
+TEST_F(SchedulerTest, AdaptivePool) {
+    auto& scheduler = Scheduler::getInstance();
+    scheduler.shutdown();
+    Scheduler::PoolConfig config;
+    config.adaptive = true;
+    config.control_interval = std::chrono::milliseconds(2);
+    // Park almost at once so the backlog below has to wake workers
+    config.spin_rounds = 0;
+    config.yield_rounds = 1;
+    EXPECT_THROW(scheduler.setPoolConfig(Scheduler::PoolConfig{64, 16, true, 0}),
+                 std::invalid_argument);
+    scheduler.setPoolConfig(config);
+    scheduler.initialize(4);
+    EXPECT_THROW(scheduler.setPoolConfig(config), std::runtime_error);
+
+    // Idle workers retire down to the minimum
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (scheduler.getActiveWorkers() > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(scheduler.getActiveWorkers(), 1u);
+
+    // A backlog of busy tasks brings them back
+    std::atomic<int> count{0};
+    size_t peak = 1;
+    for (int i = 0; i < 400; ++i) {
+        scheduler.submitTask([&count] {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            count++;
+        });
+    }
+    while (count.load() < 400) {
+        peak = std::max(peak, scheduler.getActiveWorkers());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(peak, 1u);
+
+    auto metrics = scheduler.getMetrics();
+    EXPECT_GT(metrics.worker_wakeups, 0u);
+    EXPECT_GT(metrics.idle_spin_time, 0.0);
+    EXPECT_GT(metrics.idle_park_time, 0.0);
+    EXPECT_GT(metrics.wakeup_latency.count, 0u);
+
+    scheduler.shutdown();
+    EXPECT_EQ(count.load(), 400);
+    scheduler.setPoolConfig(Scheduler::PoolConfig());
+    scheduler.initialize(4);
+}
+
+TEST_F(SchedulerTest, LatencyHistograms) {
+    // bucket bounds are within 1/16 of the value
+    for (uint64_t value : {0ull, 31ull, 32ull, 1000ull, 123456789ull}) {
+        size_t bucket = LatencyHistogram::bucketOf(value);
+        uint64_t lower = LatencyHistogram::bucketLowerBound(bucket);
+        EXPECT_LE(lower, value);
+        EXPECT_LE(value - lower, value / LatencyHistogram::kSubBuckets);
+    }
+
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value * 1000);
+    }
+    LatencyHistogram::Snapshot snapshot;
+    histogram.addTo(snapshot);
+    EXPECT_EQ(snapshot.count, 10000u);
+    EXPECT_NEAR(snapshot.percentile(0.5), 5e6, 5e6 / 16);
+    EXPECT_NEAR(snapshot.percentile(0.99), 9.9e6, 9.9e6 / 16);
+
+    auto& scheduler = Scheduler::getInstance();
+    for (int i = 0; i < 100; ++i) {
+        scheduler.submit(std::make_shared<Task>("sleepy", [](ExecutionContext&) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }));
+    }
+    scheduler.shutdown();
+    auto metrics = scheduler.getMetrics();
+    ASSERT_EQ(metrics.tasks.count("sleepy"), 1u);
+    const auto& sleepy = metrics.tasks.at("sleepy");
+    EXPECT_EQ(sleepy.execution_time.count, 100u);
+    EXPECT_GE(sleepy.execution_time.p50, 450e-6);
+    EXPECT_GE(sleepy.execution_time.p999, sleepy.execution_time.p50);
+    EXPECT_GE(metrics.execution_time.count, 100u);
+}
+
+TEST_F(SchedulerTest, TaskGraphOrder) {
+    constexpr int kWidth = 64;
+    constexpr int kLayers = 16;
+    std::vector<std::shared_ptr<Task>> tasks;
+    std::vector<int> order(kWidth * kLayers);
+    std::atomic<int> sequence{0};
+    for (int i = 0; i < kWidth * kLayers; ++i) {
+        tasks.push_back(std::make_shared<Task>("node", [&, i](ExecutionContext&) {
+            order[i] = sequence++;
+        }));
+    }
+
+    TaskGraph graph;
+    for (int i = 0; i < kWidth * kLayers; ++i) {
+        graph.addTask(tasks[i]);
+        if (i >= kWidth) {
+            graph.addDependency(tasks[i], tasks[i - kWidth]);
+            int previous = i - kWidth - i % kWidth;
+            graph.addDependency(tasks[i], tasks[previous + (i + 1) % kWidth]);
+        }
+    }
+
+    // a graph can be submitted repeatedly
+    for (int round = 0; round < 2; ++round) {
+        sequence = 0;
+        Scheduler::getInstance().submitTaskGraph(graph).get();
+        EXPECT_EQ(sequence.load(), kWidth * kLayers);
+        for (int i = kWidth; i < kWidth * kLayers; ++i) {
+            EXPECT_GT(order[i], order[i - kWidth]);
+        }
+    }
+}
+
+TEST_F(SchedulerTest, TaskGraphErrors) {
+    auto noop = [](ExecutionContext&) {};
+    auto a = std::make_shared<Task>("a", noop);
+    auto b = std::make_shared<Task>("b", noop);
+
+    TaskGraph cycle;
+    cycle.addDependency(a, b);
+    cycle.addDependency(b, a);
+    EXPECT_THROW(Scheduler::getInstance().submitTaskGraph(cycle), std::invalid_argument);
+
+    TaskGraph failing;
+    auto thrower = std::make_shared<Task>("thrower", [](ExecutionContext&) {
+        throw std::runtime_error("task failed");
+    });
+    failing.addDependency(a, thrower);
+    EXPECT_THROW(Scheduler::getInstance().submitTaskGraph(failing).get(), std::runtime_error);
+}
+
+TEST_F(SchedulerTest, GraphCancellation) {
+    std::atomic<int> runs{0};
+    auto counted = [&runs](ExecutionContext&) { runs++; };
+    auto thrower = std::make_shared<Task>("thrower", [](ExecutionContext&) {
+        throw std::runtime_error("task failed");
+    });
+    auto a1 = std::make_shared<Task>("a1", counted);
+    auto a2 = std::make_shared<Task>("a2", counted);
+    auto barrier = std::make_shared<SynchronizationTask>(
+        "barrier", counted, std::vector<std::shared_ptr<Task>>{thrower});
+    auto b = std::make_shared<Task>("b", counted);
+    auto independent = std::make_shared<Task>("independent", counted);
+
+    TaskGraph graph;
+    graph.addDependency(a1, thrower);
+    graph.addDependency(a2, a1);
+    graph.addDependency(barrier, thrower);
+    graph.addDependency(b, barrier);
+    graph.addTask(independent);
+
+    auto& scheduler = Scheduler::getInstance();
+    size_t cancelled = scheduler.getMetrics().tasks_cancelled;
+    auto executable = ExecutableGraph::capture(scheduler, graph);
+    EXPECT_THROW(executable->launch().get(), std::runtime_error);
+
+    // Dependents of the failure are skipped; the barrier cannot be cancelled
+    EXPECT_EQ(runs.load(), 2);
+    EXPECT_EQ(a1->getStatus(), TaskStatus::CANCELLED);
+    EXPECT_EQ(a2->getStatus(), TaskStatus::CANCELLED);
+    EXPECT_EQ(b->getStatus(), TaskStatus::CANCELLED);
+    EXPECT_EQ(barrier->getStatus(), TaskStatus::COMPLETED);
+    EXPECT_EQ(independent->getStatus(), TaskStatus::COMPLETED);
+    EXPECT_EQ(executable->getStats().cancelled_nodes, 3u);
+    EXPECT_EQ(scheduler.getMetrics().tasks_cancelled - cancelled, 3u);
+    EXPECT_FALSE(barrier->tryCancel());
+
+    // Kernels poll their token and stop early
+    std::atomic<bool> started{false};
+    auto spinner = std::make_shared<Task>("spinner", [&started](ExecutionContext& context) {
+        CancellationToken token = context.getCancellationToken();
+        started = true;
+        while (!token.isCancelled()) {
+            std::this_thread::yield();
+        }
+    });
+    auto after = std::make_shared<Task>("after", counted);
+    TaskGraph polling;
+    polling.addDependency(after, spinner);
+    auto long_running = ExecutableGraph::capture(scheduler, polling);
+    for (int launch = 0; launch < 2; ++launch) {
+        runs = 0;
+        started = false;
+        auto done = long_running->launch();
+        while (!started) {
+            std::this_thread::yield();
+        }
+        long_running->cancel();
+        done.get();
+        EXPECT_EQ(spinner->getStatus(), TaskStatus::CANCELLED);
+        EXPECT_EQ(after->getStatus(), TaskStatus::CANCELLED);
+        EXPECT_EQ(runs.load(), 0);
+    }
+
+    // A new launch starts from uncancelled tasks
+    runs = 0;
+    EXPECT_THROW(executable->launch().get(), std::runtime_error);
+    EXPECT_EQ(runs.load(), 2);
+    EXPECT_FALSE(ExecutionContext().isCancelled());
+}
+
+TEST_F(SchedulerTest, ResidencyShards) {
+    ResidencyTracker& residency = ResidencyTracker::getInstance();
+    residency.clear();
+
+    // Page-aligned buffers fill every shard, not just one
+    const size_t count = ResidencyTracker::kNumShards * ResidencyTracker::kMaxEntriesPerShard / 4;
+    auto page = [](size_t i) { return reinterpret_cast<const void*>((i + 1) << 12); };
+    for (size_t i = 0; i < count; ++i) {
+        residency.recordWrite(page(i), i % 4, 0);
+    }
+    size_t found = 0;
+    ResidencyTracker::Residency where{};
+    for (size_t i = 0; i < count; ++i) {
+        found += residency.lookup(page(i), where) && where.worker == i % 4;
+    }
+    EXPECT_EQ(found, count);
+    residency.clear();
+}
+
+TEST_F(SchedulerTest, DataLocality) {
+    Scheduler& scheduler = Scheduler::getInstance();
+    ResidencyTracker& residency = ResidencyTracker::getInstance();
+    residency.clear();
+    auto wait_for = [](const std::shared_ptr<Task>& task) {
+        while (task->getStatus() == TaskStatus::PENDING || task->getStatus() == TaskStatus::RUNNING) {
+            std::this_thread::yield();
+        }
+    };
+
+    std::vector<float> buffer(1024);
+    std::atomic<size_t> producer_worker{Scheduler::kNotAWorker};
+    auto producer = std::make_shared<Task>("producer", [&](ExecutionContext& context) {
+        std::fill(buffer.begin(), buffer.end(), 1.0f);
+        producer_worker = context.getWorkerIndex();
+    });
+    producer->addOutput(buffer.data(), buffer.size() * sizeof(float));
+    scheduler.submit(producer);
+    wait_for(producer);
+
+    // The output is recorded on the worker that wrote it
+    ResidencyTracker::Residency where{};
+    ASSERT_TRUE(residency.lookup(buffer.data(), where));
+    EXPECT_EQ(where.worker, producer_worker.load());
+
+    // A reader is queued on that worker; thieves may still take it
+    size_t warm_before = scheduler.getMetrics().warm_placements;
+    std::atomic<float> sum{0.0f};
+    auto consumer = std::make_shared<Task>("consumer", [&](ExecutionContext&) {
+        float total = 0.0f;
+        for (float value : buffer) {
+            total += value;
+        }
+        sum = total;
+    });
+    consumer->addInput(buffer.data(), buffer.size() * sizeof(float));
+    scheduler.submit(consumer);
+    wait_for(consumer);
+    EXPECT_EQ(sum.load(), 1024.0f);
+    EXPECT_EQ(scheduler.getMetrics().warm_placements, warm_before + 1);
+
+    // Hint-only placement ignores residency and records nothing
+    scheduler.shutdown();
+    scheduler.setPlacementPolicy(PlacementPolicy::LOCALITY_HINT);
+    EXPECT_THROW({
+        scheduler.initialize(4);
+        scheduler.setPlacementPolicy(PlacementPolicy::DATA_LOCALITY);
+    }, std::runtime_error);
+    residency.clear();
+    warm_before = scheduler.getMetrics().warm_placements;
+    consumer->reset();
+    consumer->addOutput(buffer.data(), buffer.size() * sizeof(float));
+    scheduler.submit(consumer);
+    wait_for(consumer);
+    EXPECT_EQ(residency.size(), 0u);
+    EXPECT_EQ(scheduler.getMetrics().warm_placements, warm_before);
+
+    scheduler.shutdown();
+    scheduler.setPlacementPolicy(PlacementPolicy::DATA_LOCALITY);
+    scheduler.initialize(4);
+}
+
+TEST_F(SchedulerTest, ExecutableGraphReplay) {
+    // out = sum(in) * 2, through a scratch buffer on each chain
+    auto sum = std::make_shared<ComputeTask>("sum", [](ExecutionContext& context) {
+        auto& in = context.getArgument<std::vector<int>>(0);
+        ASSERT_GE(context.getScratchSize(), sizeof(int));
+        int total = 0;
+        for (int value : in) {
+            total += value;
+        }
+        std::memcpy(context.getScratch(), &total, sizeof(int));
+    }, 0, 0);
+    auto scale = std::make_shared<ComputeTask>("scale", [](ExecutionContext& context) {
+        int total;
+        std::memcpy(&total, context.getScratch(), sizeof(int));
+        context.getArgument<int>(1) = total * 2;
+    }, 0, 0);
+    sum->setScratchRequirement(sizeof(int));
+    scale->setScratchRequirement(sizeof(int));
+
+    TaskGraph graph;
+    graph.addDependency(scale, sum);
+    auto executable = ExecutableGraph::capture(Scheduler::getInstance(), graph, 2);
+    EXPECT_EQ(executable->getStats().chains, 1u);
+    EXPECT_EQ(executable->getStats().scratch_bytes, 64u);
+
+    for (int iteration = 1; iteration <= 3; ++iteration) {
+        std::vector<int> in(100, iteration);
+        int out = 0;
+        executable->bindArgument(0, &in);
+        executable->bindArgument(1, &out);
+        executable->launch().get();
+        EXPECT_EQ(out, 200 * iteration);
+    }
+    EXPECT_EQ(executable->getStats().launches, 3u);
+    EXPECT_THROW(executable->bindArgument(2, nullptr), std::out_of_range);
+
+    // Device memory requirements are not host scratch
+    auto device_heavy = std::make_shared<ComputeTask>("device_heavy", [](ExecutionContext& context) {
+        EXPECT_EQ(context.getScratch(), nullptr);
+    }, 0, size_t(1) << 40);
+    TaskGraph heavy;
+    heavy.addTask(device_heavy);
+    auto heavy_executable = ExecutableGraph::capture(Scheduler::getInstance(), heavy);
+    EXPECT_EQ(heavy_executable->getStats().scratch_bytes, 0u);
+    heavy_executable->launch().get();
+
+    device_heavy->setScratchRequirement(SIZE_MAX);
+    EXPECT_THROW(ExecutableGraph::capture(Scheduler::getInstance(), heavy), std::length_error);
+}
+
+TEST_F(SchedulerTest, CriticalPathPolicy) {
+    auto& scheduler = Scheduler::getInstance();
+    scheduler.shutdown();
+    auto policy = std::make_unique<CriticalPathScheduler>();
+    CriticalPathScheduler* critical_path = policy.get();
+    scheduler.setSchedulingPolicy(std::move(policy));
+    scheduler.initialize(4);
+
+    // a -> b -> c on device 0 then 1, next to an independent d
+    auto noop = [](ExecutionContext&) {};
+    auto a = std::make_shared<ComputeTask>("a", noop, 0, 0);
+    auto b = std::make_shared<ComputeTask>("b", noop, 0, 0);
+    auto c = std::make_shared<ComputeTask>("c", noop, 1, 0);
+    auto d = std::make_shared<ComputeTask>("d", noop, 0, 0);
+    TaskGraph graph;
+    graph.addDependency(b, a);
+    graph.addDependency(c, b);
+    graph.addTask(d);
+
+    auto executable = ExecutableGraph::capture(scheduler, graph);
+    EXPECT_GT(critical_path->getRank(*a), critical_path->getRank(*b));
+    EXPECT_GT(critical_path->getRank(*b), critical_path->getRank(*d));
+    EXPECT_EQ(critical_path->selectTier(*a), 0u);
+    EXPECT_GT(critical_path->selectTier(*d), critical_path->selectTier(*a));
+
+    // measured times replace the defaults
+    executable->launch().get();
+    executable->reprioritize();
+    EXPECT_GT(critical_path->getRank(*a), critical_path->getRank(*c));
+    EXPECT_GE(critical_path->getRank(*c), critical_path->estimateCost(*c));
+    EXPECT_LT(critical_path->getRank(Task("other", noop)), 0.0);
+
+    // Ranks go with the graph; its tasks fall back to their priority tier
+    executable.reset();
+    EXPECT_LT(critical_path->getRank(*a), 0.0);
+    EXPECT_EQ(critical_path->selectTier(*a), critical_path->selectTier(Task("other", noop)));
+
+    // A graph outliving its policy is not released against the next one
+    struct CountingPolicy : PriorityScheduler {
+        void releaseGraph(const GraphTopology&) override { releases++; }
+        size_t releases = 0;
+    };
+    executable = ExecutableGraph::capture(scheduler, graph);
+    scheduler.shutdown();
+    auto counting = std::make_unique<CountingPolicy>();
+    CountingPolicy* replacement = counting.get();
+    scheduler.setSchedulingPolicy(std::move(counting));
+    executable.reset();
+    EXPECT_EQ(replacement->releases, 0u);
+
+    scheduler.setSchedulingPolicy(std::make_unique<PriorityScheduler>());
+    scheduler.initialize(4);
+}
+
+TEST_F(SchedulerTest, TransferLookahead) {
+    auto& scheduler = Scheduler::getInstance();
+    std::vector<float> host(256, 2.0f);
+    std::vector<float> device(256, 0.0f);
+    std::atomic<float> sum{0.0f};
+
+    auto upload = std::make_shared<MemoryTransferTask>("upload", [&](ExecutionContext&) {
+        std::copy(host.begin(), host.end(), device.begin());
+    }, -1, 0, device.size() * sizeof(float));
+    auto compute = std::make_shared<Task>("compute", [](ExecutionContext&) {});
+    auto consume = std::make_shared<Task>("consume", [&](ExecutionContext&) {
+        float total = 0.0f;
+        for (float value : device) {
+            total += value;
+        }
+        sum = total;
+    });
+    consume->addInput(device.data(), device.size() * sizeof(float));
+
+    TaskGraph graph;
+    graph.addDependency(consume, upload);
+    graph.addDependency(consume, compute);
+    auto executable = ExecutableGraph::capture(scheduler, graph);
+
+    // The consumer is within the default lookahead
+    executable->launch().get();
+    EXPECT_EQ(sum.load(), 512.0f);
+    EXPECT_EQ(executable->getStats().early_transfers, 1u);
+
+    // Over budget, or with lookahead off, the transfer waits in its chain
+    ExecutableGraph::PrefetchConfig config;
+    config.memory_budget = 512;
+    executable->setPrefetchConfig(config);
+    executable->launch().get();
+    config = ExecutableGraph::PrefetchConfig();
+    config.lookahead = 0;
+    executable->setPrefetchConfig(config);
+    std::fill(device.begin(), device.end(), 0.0f);
+    executable->launch().get();
+    EXPECT_EQ(sum.load(), 512.0f);
+    EXPECT_EQ(executable->getStats().early_transfers, 1u);
+}
+
+TEST_F(SchedulerTest, DeadlineScheduling) {
+    auto& scheduler = Scheduler::getInstance();
+    scheduler.shutdown();
+    scheduler.setSchedulingPolicy(std::make_unique<DeadlineScheduler>());
+    scheduler.initialize(1);
+    size_t misses = scheduler.getMetrics().deadline_misses;
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+    auto log = [&](const std::string& name) {
+        return [&, name](ExecutionContext&) {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(name);
+        };
+    };
+
+    // background work holds the only worker and yields once deadline work is queued
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    bool preempted = false;
+    scheduler.submit(std::make_shared<Task>("background", [&](ExecutionContext& context) {
+        started = true;
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        preempted = Scheduler::getInstance().preemptionPoint();
+        log("background")(context);
+    }, TaskPriority::LOW));
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto submit = [&](const std::string& name, std::chrono::steady_clock::time_point deadline) {
+        auto task = std::make_shared<Task>(name, log(name), TaskPriority::BACKGROUND);
+        task->setDeadline(deadline);
+        scheduler.submit(task);
+    };
+    scheduler.submit(std::make_shared<Task>("normal", log("normal")));
+    submit("late", now + std::chrono::hours(2));
+    submit("early", now - std::chrono::milliseconds(1));
+    submit("soon", now + std::chrono::hours(1));
+    release = true;
+    scheduler.shutdown();
+
+    EXPECT_TRUE(preempted);
+    EXPECT_EQ(order, (std::vector<std::string>{"early", "soon", "late", "background", "normal"}));
+    EXPECT_EQ(scheduler.getMetrics().deadline_misses - misses, 1u);
+
+    scheduler.setSchedulingPolicy(std::make_unique<PriorityScheduler>());
+    scheduler.initialize(4);
+}
+
+TEST_F(SchedulerTest, MemoryAdmission) {
+    auto& scheduler = Scheduler::getInstance();
+    scheduler.shutdown();
+    scheduler.setMemoryLimit(0, 100);
+    scheduler.initialize(4);
+
+    std::atomic<size_t> in_use{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<int> count{0};
+    auto track = [&](size_t bytes) {
+        return [&, bytes](ExecutionContext&) {
+            size_t now = in_use += bytes;
+            size_t seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            in_use -= bytes;
+            count++;
+        };
+    };
+    for (int i = 0; i < 40; ++i) {
+        size_t bytes = i % 4 == 0 ? 70 : 20;
+        scheduler.submit(std::make_shared<ComputeTask>("alloc", track(bytes), 0, bytes));
+    }
+    // larger than the whole limit, runs alone
+    scheduler.submit(std::make_shared<ComputeTask>("huge", track(150), 0, 150));
+    scheduler.shutdown();
+
+    auto stats = scheduler.getAdmissionStats(0);
+    EXPECT_EQ(count.load(), 41);
+    EXPECT_LE(peak.load(), 150u);
+    EXPECT_EQ(stats.reserved_bytes, 0u);
+    EXPECT_EQ(stats.waiting_tasks, 0u);
+    EXPECT_EQ(stats.admitted_tasks, 41u);
+    EXPECT_LE(stats.peak_reserved_bytes, 150u);
+
+    scheduler.setMemoryLimit(0, 0);
+    scheduler.initialize(4);
+}
+
+TEST_F(SchedulerTest, TaskBatch) {
+    std::vector<std::atomic<int>> hits(10000);
+    {
+        TaskBatch batch;
+        for (size_t i = 0; i < hits.size(); ++i) {
+            batch.post([&hits, i] { hits[i]++; });
+        }
+        // larger than the inline buffer
+        std::array<size_t, 16> large{};
+        large[15] = 7;
+        batch.post([&hits, large] { hits[large[15]]++; });
+        batch.wait();
+        EXPECT_EQ(batch.size(), hits.size() + 1);
+    }
+    for (size_t i = 0; i < hits.size(); ++i) {
+        EXPECT_EQ(hits[i].load(), i == 7 ? 2 : 1);
+    }
+
+    TaskBatch failing;
+    for (int i = 0; i < 100; ++i) {
+        failing.post([i] {
+            if (i == 42) {
+                throw std::runtime_error("micro task failed");
+            }
+        });
+    }
+    EXPECT_THROW(failing.wait(), std::runtime_error);
+
+    // A callable whose copy throws is never posted
+    struct ThrowingCopy {
+        ThrowingCopy() = default;
+        ThrowingCopy(const ThrowingCopy&) { throw std::runtime_error("copy failed"); }
+        void operator()() const {}
+    };
+    std::atomic<int> ran{0};
+    TaskBatch copying;
+    copying.post([&ran] { ran++; });
+    ThrowingCopy throwing;
+    EXPECT_THROW(copying.post(throwing), std::runtime_error);
+    copying.post([&ran] { ran++; });
+    EXPECT_NO_THROW(copying.wait());
+    EXPECT_EQ(copying.size(), 2u);
+    EXPECT_EQ(ran.load(), 2);
+}
+
+TEST_F(SchedulerTest, ParallelFor) {
+    std::vector<int> values(1 << 16, 0);
+    parallel_for(Range{0, values.size()}, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            values[i]++;
+        }
+    });
+    for (int value : values) {
+        ASSERT_EQ(value, 1);
+    }
+
+    EXPECT_THROW(parallel_for(Range{0, 1000}, 1, [](size_t begin, size_t) {
+        if (begin > 500) {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+}
+
+TEST_F(SchedulerTest, NestedParallelReduce) {
+    auto sum = [](size_t begin, size_t end, long total) {
+        for (size_t i = begin; i < end; ++i) {
+            total += static_cast<long>(i);
+        }
+        return total;
+    };
+    auto add = [](long a, long b) { return a + b; };
+
+    std::vector<std::future<long>> futures;
+    for (int t = 0; t < 8; ++t) {
+        futures.push_back(Scheduler::getInstance().submitTask([&] {
+            return parallel_reduce(Range{0, 64}, 1, 0L, [&](size_t begin, size_t end, long total) {
+                for (size_t i = begin; i < end; ++i) {
+                    total += parallel_reduce(Range{0, 1000}, 10, 0L, sum, add);
+                }
+                return total;
+            }, add);
+        }));
+    }
+    for (auto& future : futures) {
+        EXPECT_EQ(future.get(), 64L * 499500);
+    }
+}
+
+#ifdef UTA_HAS_COROUTINES
+namespace {
+
+uta::task<int> doubled(int value) {
+    co_return value * 2;
+}
+
+uta::task<int> pipeline(int value, std::vector<std::function<void()>>& callbacks, std::mutex& mutex) {
+    int a = co_await doubled(value);
+    co_await awaitCallback([&](std::function<void()> done) {
+        std::lock_guard<std::mutex> lock(mutex);
+        callbacks.push_back(std::move(done));
+    });
+    int b = co_await awaitFuture(Scheduler::getInstance().submitTask([value] { return value + 1; }));
+    co_return a + b;
+}
+
+uta::task<int> lateCompletions(std::future<int> value,
+                               std::vector<std::function<void()>>& callbacks, std::mutex& mutex) {
+    co_await awaitCallback([&](std::function<void()> done) {
+        std::lock_guard<std::mutex> lock(mutex);
+        callbacks.push_back(std::move(done));
+    });
+    co_return co_await awaitFuture(std::move(value));
+}
+
+} // namespace
+
+TEST_F(SchedulerTest, Coroutines) {
+    // far more suspended coroutines than workers
+    std::vector<std::function<void()>> callbacks;
+    std::mutex mutex;
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 500; ++i) {
+        futures.push_back(schedule(pipeline(i, callbacks, mutex)));
+    }
+
+    size_t completed = 0;
+    while (completed < futures.size()) {
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(callbacks);
+        }
+        for (auto& callback : ready) {
+            callback();
+        }
+        completed += ready.size();
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(futures[i].get(), 3 * i + 1);
+    }
+}
+
+TEST_F(SchedulerTest, ResumeAfterShutdown) {
+    std::vector<std::function<void()>> callbacks;
+    std::mutex mutex;
+    std::promise<int> late;
+    auto result = schedule(lateCompletions(late.get_future(), callbacks, mutex));
+    for (bool suspended = false; !suspended; std::this_thread::yield()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        suspended = !callbacks.empty();
+    }
+
+    // Both completions arrive after shutdown; the coroutine resumes inline
+    // on the callback thread and then on the future poller
+    Scheduler::getInstance().shutdown();
+    callbacks.front()();
+    late.set_value(5);
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(result.get(), 5);
+}
+#endif
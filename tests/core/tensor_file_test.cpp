@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <uta/uta.hpp>
+#include "core/io/tensor_file.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <thread>
+
+class TensorFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = ::testing::TempDir() + "tensor_file_test.utat";
+    }
+
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    std::string path_;
+};
+
+TEST_F(TensorFileTest, RoundTrip) {
+    std::vector<float> weights(1000);
+    std::iota(weights.begin(), weights.end(), 0.0f);
+    std::vector<int64_t> ids = {1, 2, 3};
+
+    uta::io::TensorFileWriter writer;
+    writer.addTensor("weight", {10, 100}, uta::DataType::FLOAT32, weights.data());
+    writer.addTensor("ids", {3}, uta::DataType::INT64, ids.data());
+    writer.write(path_);
+
+    auto file = uta::io::TensorFile::open(path_);
+    ASSERT_EQ(file->tensors().size(), 2);
+
+    const auto& weight = file->find("weight");
+    EXPECT_EQ(weight.shape, (std::vector<size_t>{10, 100}));
+    EXPECT_EQ(weight.dtype, uta::DataType::FLOAT32);
+    EXPECT_EQ(weight.size, weights.size() * sizeof(float));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(weight.data) % uta::io::kPayloadAlignment, 0);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(weight.data)[999], 999.0f);
+
+    const auto& id_view = file->find("ids");
+    EXPECT_EQ(static_cast<const int64_t*>(id_view.data)[2], 3);
+}
+
+TEST_F(TensorFileTest, SharedMapping) {
+    std::vector<float> data(16, 1.0f);
+    uta::io::TensorFileWriter writer;
+    writer.addTensor("x", {16}, uta::DataType::FLOAT32, data.data());
+    writer.write(path_);
+
+    uta::MapOptions options;
+    options.prefault_threads = 4;
+    auto a = uta::io::TensorFile::openShared(path_, options);
+    auto b = uta::io::TensorFile::openShared(path_, options);
+    EXPECT_EQ(a, b);
+
+    // Rewriting the path maps the new file; a keeps the old one
+    std::vector<float> rewritten(16, 2.0f);
+    uta::io::TensorFileWriter second;
+    second.addTensor("x", {16}, uta::DataType::FLOAT32, rewritten.data());
+    second.write(path_);
+    auto c = uta::io::TensorFile::openShared(path_, options);
+    EXPECT_NE(a, c);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(a->find("x").data)[0], 1.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(c->find("x").data)[0], 2.0f);
+    EXPECT_EQ(uta::io::TensorFile::openShared(path_), c);
+}
+
+TEST_F(TensorFileTest, ConcurrentWriters) {
+    // Each writer has its own temporary file; the last rename wins whole
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([this, t] {
+            std::vector<float> data(1 << 16, static_cast<float>(t));
+            for (int round = 0; round < 8; ++round) {
+                uta::io::TensorFileWriter writer;
+                writer.addTensor("x", {data.size()}, uta::DataType::FLOAT32, data.data());
+                uta::io::WriteOptions options;
+                options.sync = false;
+                writer.write(path_, options);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    auto file = uta::io::TensorFile::open(path_);
+    const float* data = static_cast<const float*>(file->find("x").data);
+    EXPECT_TRUE(std::all_of(data, data + (1 << 16), [data](float v) { return v == data[0]; }));
+}
+
+TEST_F(TensorFileTest, ErrorHandling) {
+    EXPECT_THROW(uta::io::TensorFile::open(path_ + ".missing"), std::runtime_error);
+
+    std::vector<float> data(4);
+    uta::io::TensorFileWriter writer;
+    writer.addTensor("x", {4}, uta::DataType::FLOAT32, data.data());
+    writer.write(path_);
+
+    auto file = uta::io::TensorFile::open(path_);
+    EXPECT_FALSE(file->contains("y"));
+    EXPECT_THROW(file->find("y"), std::invalid_argument);
+}
+
+TEST_F(TensorFileTest, CorruptIndex) {
+    std::vector<float> data(4);
+    uta::io::TensorFileWriter writer;
+    writer.addTensor("x", {4}, uta::DataType::FLOAT32, data.data());
+    writer.write(path_);
+
+    uta::io::FileHeader header;
+    {
+        std::ifstream in(path_, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    auto corrupt = [&](size_t field_offset, uint64_t value, size_t width) {
+        writer.write(path_);
+        std::fstream out(path_, std::ios::in | std::ios::out | std::ios::binary);
+        out.seekp(static_cast<std::streamoff>(header.index_offset + field_offset));
+        out.write(reinterpret_cast<const char*>(&value), static_cast<std::streamsize>(width));
+        out.close();
+        EXPECT_THROW(uta::io::TensorFile::open(path_), std::runtime_error);
+    };
+
+    // Payload size disagreeing with shape x dtype
+    corrupt(offsetof(uta::io::IndexEntry, data_size), 8, sizeof(uint64_t));
+    // Unknown data type
+    corrupt(offsetof(uta::io::IndexEntry, dtype), 99, sizeof(uint32_t));
+    // Shape whose byte size overflows
+    corrupt(offsetof(uta::io::IndexEntry, shape), UINT64_MAX / 2, sizeof(uint64_t));
+    // Payload offset that wraps around
+    corrupt(offsetof(uta::io::IndexEntry, data_offset), UINT64_MAX - 63, sizeof(uint64_t));
+}
+
+TEST_F(TensorFileTest, MapFile) {
+    std::vector<float> weights(256);
+    std::iota(weights.begin(), weights.end(), 0.0f);
+    uta::io::TensorFileWriter writer;
+    writer.addTensor("weight", {16, 16}, uta::DataType::FLOAT32, weights.data());
+    writer.write(path_);
+
+    uta::ContextConfig config{};
+    config.enabled_devices = {uta::DeviceType::CPU};
+    auto context = uta::Context::create(config);
+    auto device = context->getDevice(uta::DeviceType::CPU, 0);
+
+    auto tensor = uta::Tensor::mapFile(path_, "weight", *device);
+    EXPECT_EQ(tensor->getShape(), (std::vector<size_t>{16, 16}));
+    EXPECT_EQ(tensor->getDataType(), uta::DataType::FLOAT32);
+    EXPECT_TRUE(tensor->isReadOnly());
+
+    // The tensor aliases the shared mapping; nothing was copied
+    const uta::Tensor& view = *tensor;
+    const float* data = view.data<float>();
+    EXPECT_EQ(data, uta::io::TensorFile::openShared(path_)->find("weight").data);
+    for (size_t i = 0; i < weights.size(); ++i) {
+        EXPECT_FLOAT_EQ(data[i], weights[i]);
+    }
+    EXPECT_THROW(uta::Tensor::mapFile(path_, "missing", *device), std::invalid_argument);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <uta/uta.hpp>
+#include "core/tensor_storage.hpp"
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using uta::core::MemoryBudget;
+using uta::core::TensorStorage;
+
+class TensorStorageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uta::ContextConfig config{};
+        config.enabled_devices = {uta::DeviceType::CPU};
+        context_ = uta::Context::create(config);
+        device_ = context_->getDevice(uta::DeviceType::CPU, 0);
+    }
+
+    std::shared_ptr<uta::Tensor> makeTensor(float first) {
+        auto tensor = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+        float* data = tensor->data<float>();
+        std::iota(data, data + tensor->getSize(), first);
+        return tensor;
+    }
+
+    std::shared_ptr<uta::Context> context_;
+    std::shared_ptr<uta::Device> device_;
+};
+
+TEST_F(TensorStorageTest, MakeUnique) {
+    auto storage = TensorStorage::allocate(256);
+    EXPECT_FALSE(TensorStorage::makeUnique(storage));
+
+    // A second owner forces a private copy on write
+    auto shared = storage;
+    size_t copies = 0;
+    auto count = [&copies](void* dst, const void* src, size_t size) {
+        copies++;
+        TensorStorage::parallelCopy(dst, src, size);
+    };
+    EXPECT_TRUE(TensorStorage::makeUnique(storage, TensorStorage::allocate, count));
+    EXPECT_NE(storage->data(), shared->data());
+    EXPECT_EQ(copies, 1u);
+    EXPECT_FALSE(TensorStorage::makeUnique(shared, TensorStorage::allocate, count));
+    EXPECT_EQ(copies, 1u);
+}
+
+TEST_F(TensorStorageTest, CopyShares) {
+    auto src = makeTensor(0.0f);
+    auto dst = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+    auto before = TensorStorage::getStats();
+
+    dst->copyFrom(*src);
+    const uta::Tensor& view = *dst;
+    const uta::Tensor& src_view = *src;
+    EXPECT_EQ(view.data<float>(), src_view.data<float>());
+    EXPECT_EQ(TensorStorage::getStats().shares, before.shares + 1);
+    EXPECT_EQ(TensorStorage::getStats().materializations, before.materializations);
+    EXPECT_EQ(view.data<float>()[1023], 1023.0f);
+
+    EXPECT_THROW(dst->copyFrom(*uta::Tensor::create({8}, uta::DataType::FLOAT32, *device_)),
+                 std::runtime_error);
+}
+
+TEST_F(TensorStorageTest, UnshareOnWrite) {
+    auto src = makeTensor(0.0f);
+    auto dst = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+    dst->copyFrom(*src);
+    auto before = TensorStorage::getStats();
+
+    // The first write copies; the source keeps its values
+    float* data = dst->data<float>();
+    data[0] = 42.0f;
+    const uta::Tensor& src_view = *src;
+    EXPECT_NE(data, src_view.data<float>());
+    EXPECT_EQ(src_view.data<float>()[0], 0.0f);
+    EXPECT_EQ(data[1023], 1023.0f);
+    EXPECT_EQ(TensorStorage::getStats().materializations, before.materializations + 1);
+    EXPECT_EQ(TensorStorage::getStats().bytes_materialized,
+              before.bytes_materialized + 1024 * sizeof(float));
+
+    // Both sides own their storage again; further writes copy nothing
+    EXPECT_EQ(dst->data<float>(), data);
+    src->data<float>()[0] = 7.0f;
+    EXPECT_EQ(TensorStorage::getStats().materializations, before.materializations + 1);
+}
+
+TEST_F(TensorStorageTest, ReadOnlyStorage) {
+    auto buffer = std::make_shared<std::vector<float>>(1024, 3.0f);
+    std::shared_ptr<const void> storage(buffer, buffer->data());
+    auto wrapped = uta::Tensor::wrap({1024}, uta::DataType::FLOAT32, *device_, storage);
+    EXPECT_TRUE(wrapped->isReadOnly());
+
+    // Reads go straight to the wrapped memory
+    auto before = TensorStorage::getStats();
+    EXPECT_EQ(wrapped->data<float>(), buffer->data());
+    EXPECT_EQ(TensorStorage::getStats().materializations, before.materializations);
+
+    // A copy shares the read-only memory until it is written
+    auto copy = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+    copy->copyFrom(*wrapped);
+    EXPECT_TRUE(copy->isReadOnly());
+    float* data = copy->data<float>();
+    EXPECT_NE(data, buffer->data());
+    EXPECT_FALSE(copy->isReadOnly());
+    data[0] = 1.0f;
+    EXPECT_EQ((*buffer)[0], 3.0f);
+    EXPECT_EQ(TensorStorage::getStats().materializations, before.materializations + 1);
+
+    EXPECT_THROW(uta::Tensor::wrap({4}, uta::DataType::FLOAT32, *device_, nullptr),
+                 std::invalid_argument);
+}
+
+TEST_F(TensorStorageTest, FillUnshares) {
+    auto src = makeTensor(0.0f);
+    auto dst = uta::Tensor::create({1024}, uta::DataType::FLOAT32, *device_);
+    dst->copyFrom(*src);
+
+    // Fills write through a private copy, never the shared buffer
+    float value = 2.5f;
+    dst->fill(&value);
+    const uta::Tensor& view = *dst;
+    const uta::Tensor& src_view = *src;
+    EXPECT_NE(view.data<float>(), src_view.data<float>());
+    EXPECT_EQ(view.data<float>()[0], 2.5f);
+    EXPECT_EQ(view.data<float>()[1023], 2.5f);
+    EXPECT_EQ(src_view.data<float>()[1023], 1023.0f);
+
+    src->zero();
+    EXPECT_EQ(src_view.data<float>()[0], 0.0f);
+    EXPECT_EQ(src_view.data<float>()[1023], 0.0f);
+    EXPECT_THROW(src->fill(nullptr), std::invalid_argument);
+}
+
+TEST_F(TensorStorageTest, ManagedStorage) {
+    auto& budget = MemoryBudget::getInstance();
+    MemoryBudget::BudgetConfig config{};
+    config.memory_limit = 8192;
+    config.host_spill_limit = SIZE_MAX;
+    const uta::core::DeviceKey device{uta::DeviceType::CUDA, 110};
+    budget.configure(device, config);
+
+    auto a = TensorStorage::manage(budget.allocate(device, 4096));
+    auto b = TensorStorage::manage(budget.allocate(device, 4096));
+    EXPECT_TRUE(a->isManaged());
+    EXPECT_THROW(a->data(), std::logic_error);
+
+    std::shared_ptr<TensorStorage> c;
+    {
+        uta::TensorScope outer;
+        std::memset(a->data(), 0x61, a->size());
+        {
+            uta::TensorScope inner;
+            std::memset(b->data(), 0x62, b->size());
+            EXPECT_EQ(b->data(), b->data());
+
+            // data() pinned both; nothing can make room
+            EXPECT_THROW(budget.allocate(device, 4096), std::runtime_error);
+        }
+
+        // b's pin ended with the inner scope, so b spills
+        c = TensorStorage::manage(budget.allocate(device, 4096));
+        EXPECT_EQ(budget.getStats(device).host_spilled_bytes, 4096u);
+    }
+
+    // Out of scope, a spills too and data() faults b back in
+    uta::TensorScope scope;
+    const uint8_t* bytes = static_cast<const uint8_t*>(b->data());
+    EXPECT_EQ(bytes[0], 0x62);
+    EXPECT_EQ(bytes[4095], 0x62);
+    EXPECT_EQ(budget.getStats(device).faults, 1u);
+
+    a.reset();
+    b.reset();
+    c.reset();
+    EXPECT_EQ(budget.getStats(device).resident_bytes, 0u);
+    EXPECT_EQ(budget.getStats(device).host_spilled_bytes, 0u);
+}
+
+TEST_F(TensorStorageTest, HostDeviceIsNotBudgeted) {
+    // A memory limit on a host device registers no budget, so tensor data
+    // stays reachable without a TensorScope
+    uta::DeviceConfig config{};
+    config.type = uta::DeviceType::CPU;
+    config.device_id = 0;
+    config.memory_limit = 4096;
+    device_->configure(config);
+    EXPECT_FALSE(MemoryBudget::getInstance().isConfigured({uta::DeviceType::CPU, 0}));
+
+    auto tensor = makeTensor(1.0f);
+    EXPECT_EQ(tensor->data<float>()[1], 2.0f);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "core/runtime/topology.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace uta::runtime;
+
+class TopologyTest : public ::testing::Test {};
+
+TEST_F(TopologyTest, Placement) {
+    // 2 nodes x 2 cores x 2 hyperthreads; CPU c is core c % 4
+    std::string root = ::testing::TempDir() + "uta_sysfs";
+    auto write = [&](const std::string& path, const std::string& value) {
+        std::ofstream(root + path) << value << "\n";
+    };
+    for (const char* dir : {"", "/cpu", "/node", "/node/node0", "/node/node1"}) {
+        mkdir((root + dir).c_str(), 0755);
+    }
+    write("/cpu/online", "0-7");
+    write("/node/online", "0-1");
+    write("/node/node0/cpulist", "0-1,4-5");
+    write("/node/node1/cpulist", "2-3,6-7");
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        std::string dir = "/cpu/cpu" + std::to_string(cpu);
+        mkdir((root + dir).c_str(), 0755);
+        mkdir((root + dir + "/topology").c_str(), 0755);
+        write(dir + "/topology/core_id", std::to_string(cpu % 4));
+        write(dir + "/topology/physical_package_id", std::to_string(cpu % 4 / 2));
+    }
+
+    auto topology = CpuTopology::detect(root, false);
+    ASSERT_EQ(topology.getCpus().size(), 8u);
+    EXPECT_EQ(topology.getNumNodes(), 2u);
+
+    // compact: hyperthread siblings share a core
+    auto compact = topology.assign(AffinityPolicy::COMPACT, 4);
+    EXPECT_EQ(compact[0].cpus, std::vector<int>{0});
+    EXPECT_EQ(compact[1].cpus, std::vector<int>{4});
+
+    // scatter: physical cores first, alternating nodes
+    auto scatter = topology.assign(AffinityPolicy::SCATTER, 4);
+    EXPECT_EQ(scatter[0].node, 0);
+    EXPECT_EQ(scatter[1].node, 1);
+    EXPECT_EQ(scatter[2].cpus, std::vector<int>{1});
+    EXPECT_EQ(scatter[3].cpus, std::vector<int>{3});
+
+    auto pools = topology.assign(AffinityPolicy::NUMA_POOLS, 4);
+    EXPECT_EQ(pools[1].node, 0);
+    EXPECT_EQ(pools[2].node, 1);
+    EXPECT_EQ(pools[2].cpus, (std::vector<int>{2, 3, 6, 7}));
+
+    EXPECT_EQ(CpuTopology::parseCpuList("0-2,8"), (std::vector<int>{0, 1, 2, 8}));
+}